@@ -1,137 +1,374 @@
 #include "object.h"
 
-#include <ctype.h>
-#include <inttypes.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-// Utility functions ----------------------------------------------------------
+// Output buffering -----------------------------------------------------------
 
-// Read characters from stdin until EOF is reached, or the given predicate
-// returns true. The character for which the predicate returns true is not
-// included in the resulting string, and is put back on stdin.
-static char *read_until(int (*predicate)(int)) {
-    size_t n = 1024;
-    char *buf = malloc(n);
-    size_t i = 0;
-    while (buf) {
-        int c = getc(stdin);
-        if (c == EOF || predicate((char) c)) {
-            if (c != EOF)
-                ungetc(c, stdin);
-            buf[i] = '\0';
-            return buf;
+// All the print methods append to this buffer instead of going through printf,
+// which saves the format parsing and the stream locking on every call. The
+// buffer is written to stdout when it is full, before any input is read (so
+// that prompts are visible) and when the program exits.
+#define OUT_BUF_SIZE (1 << 16)
+
+static char out_buf[OUT_BUF_SIZE];
+static size_t out_len = 0;
+static bool out_ready = false;
+// When stdout is a terminal, flush at every end-of-line like stdio would.
+static bool out_line_buffered = false;
+
+// Write the given bytes to stdout, retrying on partial writes.
+static void write_all(const char *s, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, s, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
         }
-        buf[i] = (char) c;
-        if (i == n - 1) {
-            n *= 2;
-            buf = realloc(buf, n);
+        s += n;
+        len -= (size_t) n;
+    }
+}
+
+static void out_flush(void) {
+    if (out_len > 0) {
+        write_all(out_buf, out_len);
+        out_len = 0;
+    }
+}
+
+static void out_init(void) {
+    out_line_buffered = isatty(STDOUT_FILENO);
+    atexit(out_flush);
+    out_ready = true;
+}
+
+static void out_write(const char *s, size_t len) {
+    if (!out_ready)
+        out_init();
+    if (len > OUT_BUF_SIZE - out_len) {
+        out_flush();
+        // Too big to be worth copying, write it as is
+        if (len >= OUT_BUF_SIZE) {
+            write_all(s, len);
+            return;
         }
-        ++i;
     }
-    // If we reach this line, realloc failed an we are out-of-memory
-    return NULL;
+    memcpy(out_buf + out_len, s, len);
+    out_len += len;
+    if (out_line_buffered && memchr(s, '\n', len))
+        out_flush();
 }
 
-// Removes characters from stdin as long as they match the given predicate.
-static void skip_while(int (*predicate)(int)) {
-    int c = getc(stdin);
-    while (c != EOF && predicate(c))
-        c = getc(stdin);
-    if (c != EOF)
-        ungetc(c, stdin);
+// Two decimal digits per entry, to halve the number of divisions.
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal representation of i right-aligned before end, and
+// returns a pointer to its first character. 11 characters are always enough.
+static char *format_int32(char *end, int32_t i) {
+    // Negate as unsigned so that INT32_MIN does not overflow
+    uint32_t u = i < 0 ? 0u - (uint32_t) i : (uint32_t) i;
+    while (u >= 100) {
+        uint32_t r = u % 100;
+        u /= 100;
+        end -= 2;
+        memcpy(end, &digit_pairs[2 * r], 2);
+    }
+    if (u >= 10) {
+        end -= 2;
+        memcpy(end, &digit_pairs[2 * u], 2);
+    } else {
+        *--end = (char) ('0' + u);
+    }
+    if (i < 0)
+        *--end = '-';
+    return end;
 }
 
-static int is_eol(int c) {
-    return c == '\n';
+// Input buffering ------------------------------------------------------------
+
+// stdin is read in large chunks with read(2) into this buffer, and the input
+// methods scan it directly instead of fetching one character at a time.
+#define IN_BUF_SIZE (1 << 16)
+
+static char in_buf[IN_BUF_SIZE];
+static size_t in_pos = 0;
+static size_t in_len = 0;
+
+// Makes sure there is at least one unread character in the buffer. Returns
+// false if EOF is reached (or stdin cannot be read).
+static bool in_fill(void) {
+    if (in_pos < in_len)
+        return true;
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, in_buf, IN_BUF_SIZE);
+    } while (n < 0 && errno == EINTR);
+    in_pos = 0;
+    in_len = n > 0 ? (size_t) n : 0;
+    return in_len > 0;
+}
+
+// Same characters as isspace() in the "C" locale.
+static bool is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Growable buffer, used when a line or a word does not fit in what is left of
+// in_buf and has to be assembled from several chunks.
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} Chunks;
+
+static bool chunks_append(Chunks *chunks, const char *s, size_t len) {
+    if (chunks->len + len + 1 > chunks->cap) {
+        size_t cap = chunks->cap ? chunks->cap : 1024;
+        while (chunks->len + len + 1 > cap)
+            cap *= 2;
+        char *data = realloc(chunks->data, cap);
+        if (!data)
+            return false;
+        chunks->data = data;
+        chunks->cap = cap;
+    }
+    memcpy(chunks->data + chunks->len, s, len);
+    chunks->len += len;
+    chunks->data[chunks->len] = '\0';
+    return true;
+}
+
+// Reads characters until EOF or an end-of-line, which is left unread. Returns
+// a freshly allocated string, or NULL if we are out-of-memory.
+static char *read_line(void) {
+    Chunks chunks = {NULL, 0, 0};
+    while (in_fill()) {
+        char *start = in_buf + in_pos;
+        size_t avail = in_len - in_pos;
+        char *eol = memchr(start, '\n', avail);
+        size_t len = eol ? (size_t) (eol - start) : avail;
+        if (eol && !chunks.data) {
+            // Common case: the whole line is already in the buffer
+            char *line = malloc(len + 1);
+            if (line) {
+                memcpy(line, start, len);
+                line[len] = '\0';
+                in_pos += len;
+            }
+            return line;
+        }
+        if (!chunks_append(&chunks, start, len)) {
+            free(chunks.data);
+            return NULL;
+        }
+        in_pos += len;
+        if (eol)
+            return chunks.data;
+    }
+    if (!chunks.data)
+        return calloc(1, 1);
+    return chunks.data;
+}
+
+// Skips white spaces, then reads characters until EOF or a white space, which
+// is left unread. The word is returned with its length and without a final
+// '\0'. It points either into in_buf, or into *scratch when it had to be
+// assembled from several chunks (the caller then frees *scratch). Returns
+// NULL if we are out-of-memory.
+static const char *read_word(size_t *len, char **scratch) {
+    *scratch = NULL;
+    for (;;) {
+        if (!in_fill()) {
+            *len = 0;
+            return in_buf;
+        }
+        while (in_pos < in_len && is_space(in_buf[in_pos]))
+            ++in_pos;
+        if (in_pos < in_len)
+            break;
+    }
+
+    Chunks chunks = {NULL, 0, 0};
+    while (in_fill()) {
+        char *start = in_buf + in_pos;
+        size_t i = 0;
+        size_t avail = in_len - in_pos;
+        while (i < avail && !is_space(start[i]))
+            ++i;
+        if (i < avail && !chunks.data) {
+            // Common case: the whole word is already in the buffer
+            in_pos += i;
+            *len = i;
+            return start;
+        }
+        if (!chunks_append(&chunks, start, i)) {
+            free(chunks.data);
+            return NULL;
+        }
+        in_pos += i;
+        if (i < avail)
+            break;
+    }
+    *scratch = chunks.data;
+    *len = chunks.len;
+    return chunks.data ? chunks.data : in_buf;
+}
+
+static int digit_value(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return 16;
+}
+
+typedef enum {
+    PARSE_OK,
+    PARSE_INVALID,
+    PARSE_OVERFLOW
+} ParseResult;
+
+// Parses a VSOP integer literal (with optional +/- sign) of the given length.
+// Like the strtoll-based parsing it replaces, an empty word gives 0. Octal is
+// not allowed, contrary to strtoll base detection.
+static ParseResult parse_int32(const char *s, size_t len, int32_t *result) {
+    size_t i = 0;
+    bool negative = false;
+    if (len > 0 && (s[0] == '+' || s[0] == '-')) {
+        negative = s[0] == '-';
+        ++i;
+    }
+
+    int base = 10;
+    if (len > i + 2 && s[i] == '0' && s[i + 1] == 'x') {
+        base = 16;
+        i += 2;
+    }
+    if (len == 0) {
+        *result = 0;
+        return PARSE_OK;
+    }
+    if (i == len)
+        return PARSE_INVALID;
+
+    // Stop accumulating once above 2^31, but keep validating the digits
+    const int64_t limit = (int64_t) INT32_MAX + 1;
+    int64_t value = 0;
+    for (; i < len; ++i) {
+        int d = digit_value(s[i]);
+        if (d >= base)
+            return PARSE_INVALID;
+        if (value <= limit)
+            value = value * base + d;
+    }
+
+    if (negative)
+        value = -value;
+    if (value < INT32_MIN || value > INT32_MAX)
+        return PARSE_OVERFLOW;
+    *result = (int32_t) value;
+    return PARSE_OK;
 }
 
 // Methods --------------------------------------------------------------------
 
 Object *Object__print(Object *self, const char *s) {
-    printf("%s", s); // Note that printf(s) would allow format-string attacks
+    out_write(s, strlen(s));
     return self;
 }
 
 Object *Object__printBool(Object *self, bool b) {
-    printf("%s", b ? "true" : "false");
+    if (b)
+        out_write("true", 4);
+    else
+        out_write("false", 5);
     return self;
 }
 
 Object *Object__printInt32(Object *self, int32_t i) {
-    printf("%" PRId32, i); // PRId32 is the printf sequence for int32_t
+    char buf[16];
+    char *end = buf + sizeof buf;
+    char *start = format_int32(end, i);
+    out_write(start, (size_t) (end - start));
     return self;
 }
 
 char *Object__inputLine(Object *self __attribute__((unused))) {
-    char *line = read_until(is_eol);
+    out_flush();
+    char *line = read_line();
     if (!line)
         line = "";
     return line;
 }
 
 bool Object__inputBool(Object *self __attribute__((unused))) {
-    skip_while(isspace);
-    char *word = read_until(isspace);
+    out_flush();
+    size_t len;
+    char *scratch;
+    const char *word = read_word(&len, &scratch);
     if (!word) {
         fprintf(stderr, "Object::inputBool: cannot read word!\n");
         exit(EXIT_FAILURE);
     }
 
-    size_t len = strlen(word);
     if (len == 4 && strncmp(word, "true", 4) == 0) {
-        free(word);
+        free(scratch);
         return true;
     } else if (len == 5 && strncmp(word, "false", 5) == 0) {
-        free(word);
+        free(scratch);
         return false;
     } else {
-        fprintf(stderr, "Object::inputBool: `%s` is not a valid boolean!\n",
-                word);
-        free(word);
+        fprintf(stderr, "Object::inputBool: `%.*s` is not a valid boolean!\n",
+                (int) len, word);
+        free(scratch);
         exit(EXIT_FAILURE);
     }
 }
 
 int32_t Object__inputInt32(Object *self __attribute__((unused))) {
-    skip_while(isspace);
-    char *word = read_until(isspace);
+    out_flush();
+    size_t len;
+    char *scratch;
+    const char *word = read_word(&len, &scratch);
     if (!word) {
         fprintf(stderr, "Object::inputInt32: cannot read word!\n");
         exit(EXIT_FAILURE);
     }
 
-    char *p;
-    long long int i;
-    size_t len = strlen(word);
-    // We can't use strtoll base detection since it also allows octal, contrary
-    // to VSOP
-    bool is_hex =
-        (len > 2 && word[0] == '0' && word[1] == 'x')
-        || (len > 3 && (word[0] == '+' || word[0] == '-') && word[1] == '0'
-                && word[2] == 'x');
-    if (is_hex) {
-        i = strtoll(word, &p, 16);
-    } else {
-        i = strtoll(word, &p, 10);
+    int32_t i;
+    switch (parse_int32(word, len, &i)) {
+        case PARSE_OK:
+            free(scratch);
+            return i;
+        case PARSE_INVALID:
+            fprintf(stderr,
+                    "Object::inputInt32: `%.*s` is not a valid integer literal!\n",
+                    (int) len, word);
+            break;
+        case PARSE_OVERFLOW:
+            fprintf(stderr,
+                    "Object::inputInt32: `%.*s` does not fit a 32-bit integer!\n",
+                    (int) len, word);
+            break;
     }
-
-    if (*p != '\0') {
-        fprintf(stderr,
-                "Object::inputInt32: `%s` is not a valid integer literal!\n",
-                word);
-        exit(EXIT_FAILURE);
-    }
-
-    if (i < INT32_MIN || i > INT32_MAX) {
-        fprintf(stderr,
-                "Object::inputInt32: `%s` does not fit a 32-bit integer!\n",
-                word);
-        exit(EXIT_FAILURE);
-    }
-
-    return (int32_t) i;
+    exit(EXIT_FAILURE);
 }
 
 // Constructor ----------------------------------------------------------------
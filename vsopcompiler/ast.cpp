@@ -8,13 +8,37 @@
 using namespace AST;
 
 bool checkMode = false;
+bool recoverableErrors = false;
 
-static const std::unordered_map<Type, std::string> type_map = {
-    {Type::INT32,"int32"},
-    {Type::BOOL,"bool"},
-    {Type::STRING,"string"},
-    {Type::UNIT,"unit"}
-};
+std::size_t AstNode::count = 0;
+
+/*
+ *   Type table
+ */
+
+const TypeId TypeTable::UNIT;
+const TypeId TypeTable::BOOL;
+const TypeId TypeTable::INT32;
+const TypeId TypeTable::STRING;
+const TypeId TypeTable::OBJECT;
+
+const std::string TypeTable::BUILTIN_NAMES[OBJECT + 1] = {"unit", "bool", "int32", "string", "Object"};
+
+TypeTable::TypeTable() {
+    for (TypeId id = UNIT; id <= OBJECT; id++)
+        ids_.emplace(BUILTIN_NAMES[id], id);
+}
+
+TypeId TypeTable::intern(const std::string& name) {
+    auto it = ids_.find(name);
+    if (it != ids_.end())
+        return it->second;
+
+    TypeId id = size();
+    names_.push_back(name);
+    ids_.emplace(name, id);
+    return id;
+}
 
 /*
  *   Helpers
@@ -42,7 +66,7 @@ std::string optional_expr(const ExprNode* expr) {
 }
 
 // Converts an operator to its corresponding string representation.
-std::string operatorToString(Operator op) {
+std::string AST::operatorToString(Operator op) {
     switch (op) {
         case Operator::AND:
             return "and";
@@ -77,100 +101,97 @@ std::string operatorToString(Operator op) {
 
 // constructor
 ProgramNode::ProgramNode(std::vector<ClassNode*> classes, const std::string& filename, int line, int column)
-: filename(filename), line(line), column(column), classes_(classes) {
-    std::string* type = new std::string("Object");
-    AST::TypeNode* typeNodeObject = new AST::TypeNode(type, filename, 0, 0);
-
+: filename(filename), line(line), column(column), classes_(std::move(classes)) {
     // print(s : string) : Object
-    std::string* name = new std::string("s");
-    type = new std::string("string");
-    AST::TypeNode* typeNode = new AST::TypeNode(type, filename, 0, 0);
-    AST::FormalNode* formal = new AST::FormalNode(name, typeNode);
+    std::string name = "s";
+    std::string type = "string";
+    AST::TypeNode* typeNode = new AST::TypeNode(&type, filename, 0, 0);
+    AST::FormalNode* formal = new AST::FormalNode(&name, typeNode);
     std::vector<AST::FormalNode*> formalVectPrint;
     formalVectPrint.push_back(formal);
     AST::FormalsNode* formalsPrint = new AST::FormalsNode(formalVectPrint);
 
-    name = new std::string("print");
+    name = "print";
     std::vector<AST::ExprNode*> expr_list_print;
     AST::BlockNode* blockNodePrint = new AST::BlockNode(expr_list_print);
-    blockNodePrint->setType(Type::CLASS);
-    blockNodePrint->setTypename("Object");
-    AST::MethodNode* print = new AST::MethodNode(name, formalsPrint, typeNodeObject, blockNodePrint, filename, 0, 0);
+    blockNodePrint->setTypeId(TypeTable::OBJECT);
+    type = "Object";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
+    AST::MethodNode* print = new AST::MethodNode(&name, formalsPrint, typeNode, blockNodePrint, filename, 0, 0);
 
     // printBool(b : bool) : Object
-    name = new std::string("b");
-    type = new std::string("bool");
-    typeNode = new AST::TypeNode(type, filename, 0, 0);
-    formal = new AST::FormalNode(name, typeNode);
+    name = "b";
+    type = "bool";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
+    formal = new AST::FormalNode(&name, typeNode);
     std::vector<AST::FormalNode*> formalVectPrintBool;
     formalVectPrintBool.push_back(formal);
     AST::FormalsNode* formalsPrintBool = new AST::FormalsNode(formalVectPrintBool);
 
-    name = new std::string("printBool");
+    name = "printBool";
     std::vector<AST::ExprNode*> expr_list_printBool;
     AST::BlockNode* blockNodePrintBool = new AST::BlockNode(expr_list_printBool);
-    blockNodePrintBool->setType(Type::CLASS);
-    blockNodePrintBool->setTypename("Object");
-    AST::MethodNode* printBool = new AST::MethodNode(name, formalsPrintBool, typeNodeObject, blockNodePrintBool, filename, 0, 0);
+    blockNodePrintBool->setTypeId(TypeTable::OBJECT);
+    type = "Object";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
+    AST::MethodNode* printBool = new AST::MethodNode(&name, formalsPrintBool, typeNode, blockNodePrintBool, filename, 0, 0);
 
     // printInt32(i : int32) : Object
-    name = new std::string("i");
-    type = new std::string("int32");
-    typeNode = new AST::TypeNode(type, filename, 0, 0);
-    formal = new AST::FormalNode(name, typeNode);
+    name = "i";
+    type = "int32";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
+    formal = new AST::FormalNode(&name, typeNode);
     std::vector<AST::FormalNode*> formalVectPrintInt32;
     formalVectPrintInt32.push_back(formal);
     AST::FormalsNode* formalsPrintInt32 = new AST::FormalsNode(formalVectPrintInt32);
 
-    name = new std::string("printInt32");
+    name = "printInt32";
     std::vector<AST::ExprNode*> expr_list_printInt32;
     AST::BlockNode* blockNodePrintInt32 = new AST::BlockNode(expr_list_printInt32);
-    blockNodePrintInt32->setType(Type::CLASS);
-    blockNodePrintInt32->setTypename("Object");
-    AST::MethodNode* printInt32 = new AST::MethodNode(name, formalsPrintInt32, typeNodeObject, blockNodePrintInt32, filename, 0, 0);
+    blockNodePrintInt32->setTypeId(TypeTable::OBJECT);
+    type = "Object";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
+    AST::MethodNode* printInt32 = new AST::MethodNode(&name, formalsPrintInt32, typeNode, blockNodePrintInt32, filename, 0, 0);
 
     // inputLine() : string
     std::vector<AST::FormalNode*> formalVectInputLine;
     AST::FormalsNode* formalsInputLine = new AST::FormalsNode(formalVectInputLine);
-    type = new std::string("string");
-    typeNode = new AST::TypeNode(type, filename, 0, 0);
+    type = "string";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
 
-    name = new std::string("inputLine");
+    name = "inputLine";
     std::vector<AST::ExprNode*> expr_list_inputLine;
     AST::BlockNode* blockNodeInputLine = new AST::BlockNode(expr_list_inputLine);
-    blockNodeInputLine->setType(Type::STRING);
-    blockNodeInputLine->setTypename("string");
-    AST::MethodNode* inputLine = new AST::MethodNode(name, formalsInputLine, typeNode, blockNodeInputLine, filename, 0, 0);
+    blockNodeInputLine->setTypeId(TypeTable::STRING);
+    AST::MethodNode* inputLine = new AST::MethodNode(&name, formalsInputLine, typeNode, blockNodeInputLine, filename, 0, 0);
 
     // inputBool() : bool
     std::vector<AST::FormalNode*> formalVectInputBool;
     AST::FormalsNode* formalsInputBool = new AST::FormalsNode(formalVectInputBool);
-    type = new std::string("bool");
-    typeNode = new AST::TypeNode(type, filename, 0, 0);
+    type = "bool";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
 
-    name = new std::string("inputBool");
+    name = "inputBool";
     std::vector<AST::ExprNode*> expr_list_inputBool;
     AST::BlockNode* blockNodeInputBool = new AST::BlockNode(expr_list_inputBool);
-    blockNodeInputBool->setType(Type::BOOL);
-    blockNodeInputBool->setTypename("bool");
-    AST::MethodNode* inputBool = new AST::MethodNode(name, formalsInputBool, typeNode, blockNodeInputBool, filename, 0, 0);
+    blockNodeInputBool->setTypeId(TypeTable::BOOL);
+    AST::MethodNode* inputBool = new AST::MethodNode(&name, formalsInputBool, typeNode, blockNodeInputBool, filename, 0, 0);
 
     // inputInt32() : int32
     std::vector<AST::FormalNode*> formalVectInputInt32;
     AST::FormalsNode* formalsInputInt32 = new AST::FormalsNode(formalVectInputInt32);
-    type = new std::string("int32");
-    typeNode = new AST::TypeNode(type, filename, 0, 0);
+    type = "int32";
+    typeNode = new AST::TypeNode(&type, filename, 0, 0);
 
-    name = new std::string("inputInt32");
+    name = "inputInt32";
     std::vector<AST::ExprNode*> expr_list_inputInt32;
     AST::BlockNode* blockNodeInputInt32 = new AST::BlockNode(expr_list_inputInt32);
-    blockNodeInputInt32->setType(Type::INT32);
-    blockNodeInputInt32->setTypename("int32");
-    AST::MethodNode* inputInt32 = new AST::MethodNode(name, formalsInputInt32, typeNode, blockNodeInputInt32, filename, 0, 0);
+    blockNodeInputInt32->setTypeId(TypeTable::INT32);
+    AST::MethodNode* inputInt32 = new AST::MethodNode(&name, formalsInputInt32, typeNode, blockNodeInputInt32, filename, 0, 0);
 
     // add Object class
-    name = new std::string("Object");
-    std::string* parent = new std::string("");
+    name = "Object";
+    std::string parent = "";
     std::vector<AST::FieldNode*> fields;
     std::vector<AST::MethodNode*> methods;
     // Adding object prototypes to methods vector
@@ -181,7 +202,7 @@ ProgramNode::ProgramNode(std::vector<ClassNode*> classes, const std::string& fil
     methods.push_back(inputBool);
     methods.push_back(inputInt32);
     AST::ClassBodyNode* class_body = new AST::ClassBodyNode(fields, methods);
-    AST::ClassNode* objectCls = new AST::ClassNode(name, parent, class_body, filename, 0, 0);
+    AST::ClassNode* objectCls = new AST::ClassNode(&name, &parent, class_body, filename, 0, 0);
 
     // add Object class to the classes_ vector at 1st position
     classes_.insert(classes_.begin(), objectCls);
@@ -220,7 +241,7 @@ std::string ClassNode::evaluate() const {
 }
 // constructor
 ClassBodyNode::ClassBodyNode(std::vector<FieldNode*> fields, std::vector<MethodNode*> methods)
-: fields_(fields), methods_(methods) {}
+: fields_(std::move(fields)), methods_(std::move(methods)) {}
 
 // evaluate
 std::string ClassBodyNode::evaluate() const {
@@ -275,24 +296,11 @@ std::string MethodNode::evaluate() const {
 
     std::string type = "";
     if (checkMode) {
-        
-        std::string typestr = "";
         if (!block_->getExpr().empty()) {
-            Type typet = block_->getExpr().back()->getType();
-
-            const auto it = type_map.find(typet);
-
-            if (it != type_map.end()) {
-                typestr = it->second;
-            } else {
-                typestr = block_->getExpr().back()->getTypename();
-            }
+            type = " : " + block_->getExpr().back()->getTypename();
         } else {
-
-            typestr = block_->getTypename();
+            type = " : " + block_->getTypename();
         }
-        
-        type = " : " + typestr; 
     }
 
     return "Method(" + name_ + ", " + formalsString + ", " + ret_type_->evaluate() + ", " + blockString + type + ")" ;
@@ -318,7 +326,7 @@ std::string TypeNode::evaluate() const {
  */
 
 // constructor
-FormalsNode::FormalsNode(std::vector<FormalNode*> formals) : formals_(formals) {}
+FormalsNode::FormalsNode(std::vector<FormalNode*> formals) : formals_(std::move(formals)) {}
 
 // evaluate
 std::string FormalsNode::evaluate() const {
@@ -346,7 +354,7 @@ std::string FormalNode::evaluate() const {
  */
 
 // constructor
-BlockNode::BlockNode(std::vector<ExprNode*> expr_list) : expr_list_(expr_list) {}
+BlockNode::BlockNode(std::vector<ExprNode*> expr_list) : expr_list_(std::move(expr_list)) {}
 
 // evaluate
 std::string BlockNode::evaluate() const {
@@ -375,16 +383,7 @@ BlockExprNode::BlockExprNode(BlockNode* block, const std::string& filename, int
 std::string BlockExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return block_->evaluate() + type;
 }
@@ -398,16 +397,7 @@ ExprNode* else_expr, const std::string& filename, int line, int column)
 std::string IfThenElseExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "If(" + cond_expr_->evaluate() + ", " + then_expr_->evaluate() + optional_expr(else_expr_) + ")" + type;
 }
@@ -421,16 +411,7 @@ const std::string& filename, int line, int column)
 std::string WhileDoExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "While(" + cond_expr_->evaluate() + ", " + body_expr_->evaluate() + ")" + type;
 }
@@ -445,16 +426,7 @@ type_node_(type_node), init_expr_(init_expr), scope_expr_(scope_expr)  {}
 std::string LetExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "Let(" + name_ + ", " + type_node_->evaluate() + optional_expr(init_expr_) + ", " + scope_expr_->evaluate() + ")" + type;
 }
@@ -468,16 +440,7 @@ const std::string& filename, int line, int column)
 std::string AssignExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-         
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "Assign(" + name_str_ + ", " + expr_->evaluate() + ")" + type;
 }
@@ -495,16 +458,7 @@ const std::string& filename, int line, int column)
 std::string BinaryExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "BinOp(" + operatorToString(op_) + ", " + left_expr_->evaluate() + ", " + right_expr_->evaluate() + ")" + type;
 }
@@ -597,16 +551,7 @@ IsNullNode::IsNullNode(ExprNode* expr, const std::string& filename, int line, in
 std::string IsNullNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "UnOp(" + operatorToString(op_) + ", " + expr_->evaluate() + ")" + type;
 }
@@ -623,16 +568,7 @@ const std::string& filename, int line, int column)
 std::string CallExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-        
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "Call(" + obj_expr_->evaluate() + ", " + method_name_ + ", " + expr_list_->evaluate() + ")"  + type;
 }
@@ -649,16 +585,7 @@ NewExprNode::NewExprNode(std::string* type_name, const std::string& filename, in
 std::string NewExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-           
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return "New(" + type_name_ + ")"  + type;
 }
@@ -675,16 +602,7 @@ VariableExprNode::VariableExprNode(std::string* variable_name, const std::string
 std::string VariableExprNode::evaluate() const {
     std::string type = "";
     if (checkMode) {
-        Type typet = getType();
-        std::string typestr = "";
-        const auto it = type_map.find(typet);
-        if (it != type_map.end()) {
-            typestr = it->second;
-        } else {
-            typestr = getTypename();
-        }
-          
-        type = " : " + typestr; 
+        type = " : " + getTypename();
     }
     return variable_name_ + type;
 }
@@ -714,7 +632,7 @@ std::string ParExprNode::evaluate() const {
 }
 
 // constructor
-ArgsNode::ArgsNode(std::vector<ExprNode*> exprs) : exprs_(exprs) {}
+ArgsNode::ArgsNode(std::vector<ExprNode*> exprs) : exprs_(std::move(exprs)) {}
 
 // evaluate
 std::string ArgsNode::evaluate() const {
@@ -740,6 +658,10 @@ std::string IntegerLiteralNode::evaluate() const {
     return integerliteral_ + type;
 }
 
+int32_t IntegerLiteralNode::getValue() const {
+    return std::stoi(integerliteral_);
+}
+
 // constructor
 LiteralNode::LiteralNode(std::string* literal, const std::string& filename, int line, int column)
 : ExprNode(filename, line, column), literal_(std::move(*literal)) {}
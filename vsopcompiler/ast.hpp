@@ -3,9 +3,15 @@
 
 #pragma once
 
+#include <cassert>
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
 
 namespace AST {
 
@@ -69,6 +75,9 @@ namespace AST {
         ISNULL,
     };
 
+    // The operator as in the source, "unknown" for an invalid one
+    std::string operatorToString(Operator op);
+
     /*
     */
     enum class Type {
@@ -79,6 +88,53 @@ namespace AST {
         CLASS
     };
 
+    // Id of a canonical type, see TypeTable
+    typedef std::uint32_t TypeId;
+
+    /*
+    *   One canonical type per builtin type and per class name, so that the
+    *   types of expressions are compared as integers. The ids of the
+    *   primitive types are the values of their Type.
+    *
+    *   A table belongs to a compilation, or to a document of the daemon, and
+    *   must outlive the nodes typed with it. The builtin types and Object
+    *   have the same id and name in every table.
+    */
+    class TypeTable {
+        public:
+            static const TypeId UNIT = 0;
+            static const TypeId BOOL = 1;
+            static const TypeId INT32 = 2;
+            static const TypeId STRING = 3;
+            static const TypeId OBJECT = 4;
+
+            TypeTable();
+
+            // Id of a type name, added to the table the first time
+            TypeId intern(const std::string& name);
+
+            const std::string& name(TypeId id) const {
+                return id <= OBJECT ? builtinName(id) : names_[id - OBJECT - 1];
+            }
+
+            static const std::string& builtinName(TypeId id) { return BUILTIN_NAMES[id]; }
+
+            static Type kind(TypeId id) {
+                return id < OBJECT ? static_cast<Type>(id) : Type::CLASS;
+            }
+
+            // Number of types in the table, the ids are below it
+            TypeId size() const { return static_cast<TypeId>(OBJECT + 1 + names_.size()); }
+
+        private:
+            static const std::string BUILTIN_NAMES[OBJECT + 1];
+
+            // The classes other than Object, in a deque so that the names
+            // given to the nodes stay valid when the table grows
+            std::deque<std::string> names_;
+            std::unordered_map<std::string, TypeId> ids_;
+    };
+
     class Visitor {
         public:
             virtual void visit(ProgramNode* node) = 0;
@@ -129,8 +185,12 @@ namespace AST {
     */
     class AstNode {
         public:
+            AstNode() { count++; }
             virtual ~AstNode() = default;
             virtual void accept(Visitor* visitor) = 0;
+
+            // Number of nodes created, reported by --stats
+            static std::size_t count;
     };
 
     /*
@@ -144,6 +204,7 @@ namespace AST {
             std::string evaluate() const;
 
             const std::vector<ClassNode*>& getClasses() const { return classes_; }
+            void setClasses(std::vector<ClassNode*> classes) { classes_ = std::move(classes); }
 
             std::string getFilename() const { return filename; }
             int getLine() const { return line; }
@@ -244,14 +305,20 @@ namespace AST {
             int getLine() const { return line; }
             int getColumn() const { return column; }
 
-            Type getType() const { return type_; }
-            void setType(Type t) {
+            Type getType() const { return TypeTable::kind(type_); }
+            const std::string& getTypename() const { return *typename_; }
+
+            TypeId getTypeId() const { return type_; }
+            // A type of the table, which keeps its name
+            void setTypeId(TypeId t, const TypeTable& types) {
                 type_ = t;
+                typename_ = &types.name(t);
             }
-
-            std::string  getTypename() const { return typename_; }
-            void setTypename(std::string t) {
-                typename_ = t;
+            // A builtin type or Object
+            void setTypeId(TypeId t) {
+                assert(t <= TypeTable::OBJECT);
+                type_ = t;
+                typename_ = &TypeTable::builtinName(t);
             }
         
         protected:
@@ -260,8 +327,8 @@ namespace AST {
             int column;
 
         private:
-            Type type_;
-            std::string typename_;
+            TypeId type_ = TypeTable::UNIT;
+            const std::string* typename_ = &TypeTable::builtinName(TypeTable::UNIT);
     };
 
     class IfThenElseExprNode : public ExprNode {
@@ -276,6 +343,9 @@ namespace AST {
             ExprNode* getCondExpr() { return cond_expr_; }
             ExprNode* getThenExpr() { return then_expr_; }
             ExprNode* getElseExpr() { return else_expr_; }
+            void setCondExpr(ExprNode* e) { cond_expr_ = e; }
+            void setThenExpr(ExprNode* e) { then_expr_ = e; }
+            void setElseExpr(ExprNode* e) { else_expr_ = e; }
 
         private:
             ExprNode* cond_expr_;
@@ -293,6 +363,8 @@ namespace AST {
             virtual ~WhileDoExprNode() { delete cond_expr_; delete body_expr_; }
             ExprNode* getCondExpr() { return cond_expr_; }
             ExprNode* getBodyExpr() { return body_expr_; }
+            void setCondExpr(ExprNode* e) { cond_expr_ = e; }
+            void setBodyExpr(ExprNode* e) { body_expr_ = e; }
 
         private:
             ExprNode* cond_expr_;
@@ -310,6 +382,8 @@ namespace AST {
             TypeNode* getTypeNode() { return type_node_; }
             ExprNode* getInitExpr() { return init_expr_; }
             ExprNode* getScopeExpr() { return scope_expr_; }
+            void setInitExpr(ExprNode* e) { init_expr_ = e; }
+            void setScopeExpr(ExprNode* e) { scope_expr_ = e; }
 
             ~LetExprNode() { delete type_node_; delete init_expr_; delete scope_expr_;}
 
@@ -330,8 +404,9 @@ namespace AST {
             const std::string& getNameStr() const { return name_str_; }
             ExprNode* getName() { return name_; }
             ExprNode* getExpr() { return expr_; }
+            void setExpr(ExprNode* e) { expr_ = e; }
 
-            ~AssignExprNode() { delete expr_; }
+            ~AssignExprNode() { delete name_; delete expr_; }
 
         private:
             std::string name_str_;
@@ -349,6 +424,8 @@ namespace AST {
             virtual ~BinaryExprNode() { delete left_expr_; delete right_expr_; }
             ExprNode* getLeftExpr() { return left_expr_; }
             ExprNode* getRightExpr() { return right_expr_; }
+            void setLeftExpr(ExprNode* e) { left_expr_ = e; }
+            void setRightExpr(ExprNode* e) { right_expr_ = e; }
             Operator getOp() const { return op_; }
 
 
@@ -432,6 +509,7 @@ namespace AST {
 
             virtual ~UnaryExprNode() { delete expr_; }
             ExprNode* getNode() { return expr_; }
+            void setNode(ExprNode* e) { expr_ = e; }
             Operator getOperator() const { return op_; }
 
         protected:
@@ -519,6 +597,7 @@ namespace AST {
 
             virtual ~ParExprNode() { delete expr_; }
             ExprNode* getExpr() { return expr_; }
+            void setExpr(ExprNode* e) { expr_ = e; }
 
         private:
             ExprNode* expr_;
@@ -540,19 +619,25 @@ namespace AST {
                 }
             }
 
-            Type getType() const { return type_; }
-            void setType(Type t) {
+            Type getType() const { return TypeTable::kind(type_); }
+            const std::string& getTypename() const { return *typename_; }
+
+            TypeId getTypeId() const { return type_; }
+            // A type of the table, which keeps its name
+            void setTypeId(TypeId t, const TypeTable& types) {
                 type_ = t;
+                typename_ = &types.name(t);
             }
-
-            std::string  getTypename() const { return typename_; }
-            void setTypename(std::string t) {
-                typename_ = t;
+            // A builtin type or Object
+            void setTypeId(TypeId t) {
+                assert(t <= TypeTable::OBJECT);
+                type_ = t;
+                typename_ = &TypeTable::builtinName(t);
             }
 
         private:
-            Type type_;
-            std::string typename_;
+            TypeId type_ = TypeTable::UNIT;
+            const std::string* typename_ = &TypeTable::builtinName(TypeTable::UNIT);
             std::vector<ExprNode*> expr_list_;
     };
 
@@ -566,6 +651,7 @@ namespace AST {
             std::string evaluate() const override;
 
             BlockNode* getBlock() { return block_; }
+            void setBlock(BlockNode* b) { block_ = b; }
 
             ~BlockExprNode() { delete block_; }
 
@@ -604,6 +690,7 @@ namespace AST {
             const std::string& getName() const { return name_; }
             TypeNode* getType() { return type_; }
             ExprNode* getInitExpr() { return init_expr_; }
+            void setInitExpr(ExprNode* e) { init_expr_ = e; }
 
             ~FieldNode() { delete type_; delete init_expr_; }
 
@@ -636,6 +723,7 @@ namespace AST {
             FormalsNode* getFormals() { return formals_; }
             TypeNode* getRetType() { return ret_type_; }
             BlockNode* getBlock() { return block_; }
+            void setBlock(BlockNode* b) { block_ = b; }
 
             ~MethodNode() {
                 delete formals_;
@@ -667,6 +755,7 @@ namespace AST {
 
             const std::vector<FieldNode*>& getFields() const { return fields_; }
             const std::vector<MethodNode*>& getMethods() const { return methods_; }
+            void setMethods(std::vector<MethodNode*> methods) { methods_ = std::move(methods); }
 
             ~ClassBodyNode() {
                 for (auto f : fields_) {
@@ -734,6 +823,7 @@ namespace AST {
 
             const std::string& getMethodName() const { return method_name_; }
             ExprNode* getObjExpr() { return obj_expr_; }
+            void setObjExpr(ExprNode* e) { obj_expr_ = e; }
             ArgsNode* getExprList() { return expr_list_; }
 
             ~CallExprNode() { delete obj_expr_; delete expr_list_;}
@@ -752,6 +842,8 @@ namespace AST {
             std::string evaluate() const override;
 
             const std::string& getIntegerLiteral() const { return integerliteral_; }
+            // The value of the literal, in the int32 range once lexed
+            int32_t getValue() const;
 
         private:
             std::string integerliteral_;
@@ -0,0 +1,80 @@
+#!/bin/bash
+#
+# Time each vsopc mode on generated programs of increasing size.
+#
+# For each shape, mode and size, the best time of $REPEAT runs is reported
+# with the ratio to the previous size and the estimated exponent k of
+# time ~ size^k. k close to 1 is linear, a k well above 1 is super-linear.
+#
+# Environment:
+#   VSOPC     compiler to benchmark (default: ./vsopc)
+#   FLAGS     flags given to the compiler before the mode, e.g. --parser=fast
+#   GENERATE  program generator (default: ./bench/generate)
+#   SHAPES    shapes to generate (default: deep wide let expr methods)
+#   MODES     vsopc modes to time (default: -l -p -c -i)
+#   SIZES     program sizes, in increasing order (default: 250 500 1000 2000 4000)
+#   REPEAT    runs per measure (default: 3)
+#   OUT       directory of the generated programs (default: bench/out)
+
+VSOPC=${VSOPC:-./vsopc}
+FLAGS=${FLAGS:-}
+GENERATE=${GENERATE:-./bench/generate}
+SHAPES=${SHAPES:-deep wide let expr methods}
+MODES=${MODES:--l -p -c -i}
+SIZES=${SIZES:-250 500 1000 2000 4000}
+REPEAT=${REPEAT:-3}
+OUT=${OUT:-bench/out}
+
+mkdir -p "$OUT"
+
+# Best wall time of $REPEAT runs of "$VSOPC $FLAGS $1 $2", in seconds, or "fail".
+measure() {
+    local best="" t
+    for ((r = 0; r < REPEAT; r++)); do
+        local start=$(date +%s%N)
+        if ! "$VSOPC" $FLAGS "$1" "$2" > /dev/null 2>&1; then
+            echo fail
+            return
+        fi
+        local end=$(date +%s%N)
+        t=$(( (end - start) / 1000 ))
+        if [ -z "$best" ] || [ "$t" -lt "$best" ]; then
+            best=$t
+        fi
+    done
+    awk -v us="$best" 'BEGIN { printf "%.4f", us / 1e6 }'
+}
+
+printf "%-8s %-4s %8s %10s %8s %8s\n" shape mode size "time (s)" ratio k
+
+for shape in $SHAPES; do
+    for size in $SIZES; do
+        "$GENERATE" "$shape" "$size" > "$OUT/$shape-$size.vsop"
+    done
+
+    for mode in $MODES; do
+        prev_size=""
+        prev_time=""
+
+        for size in $SIZES; do
+            time=$(measure "$mode" "$OUT/$shape-$size.vsop")
+
+            if [ "$time" = fail ] || [ -z "$prev_time" ] || [ "$prev_time" = fail ]; then
+                printf "%-8s %-4s %8d %10s %8s %8s\n" "$shape" "$mode" "$size" "$time" - -
+            else
+                awk -v shape="$shape" -v mode="$mode" -v n="$size" -v t="$time" \
+                    -v pn="$prev_size" -v pt="$prev_time" 'BEGIN {
+                    if (pt > 0 && t > 0) {
+                        ratio = t / pt
+                        printf "%-8s %-4s %8d %10.4f %8.2f %8.2f\n", shape, mode, n, t, ratio, log(ratio) / log(n / pn)
+                    } else {
+                        printf "%-8s %-4s %8d %10.4f %8s %8s\n", shape, mode, n, t, "-", "-"
+                    }
+                }'
+            fi
+
+            prev_size=$size
+            prev_time=$time
+        done
+    done
+done
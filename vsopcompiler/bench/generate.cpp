@@ -0,0 +1,151 @@
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+
+/*
+    Deterministic generator of large, well-typed VSOP programs for the compiler benchmarks.
+
+    Usage: generate <shape> <size>
+
+    deep     a chain of <size> classes, each one extending the previous one
+    wide     one class with <size> fields and <size> methods
+    let      <size> nested let expressions
+    expr     one arithmetic expression with <size> operators
+    methods  <size> methods of Main, each one calling the previous one
+*/
+
+using namespace std;
+
+static void deep(int size) {
+    cout << "class C0 {\n"
+         << "    f0 : int32 <- 0;\n"
+         << "    m0() : int32 { f0 }\n"
+         << "}\n";
+
+    for (int i = 1; i < size; i++) {
+        cout << "class C" << i << " extends C" << i - 1 << " {\n"
+             << "    f" << i << " : int32 <- " << i << ";\n"
+             << "    m" << i << "() : int32 { m" << i - 1 << "() + f" << i << " }\n"
+             << "}\n";
+    }
+
+    cout << "class Main {\n"
+         << "    main() : int32 {\n"
+         << "        printInt32((new C" << size - 1 << ").m" << size - 1 << "());\n"
+         << "        print(\"\\n\");\n"
+         << "        0\n"
+         << "    }\n"
+         << "}\n";
+}
+
+static void wide(int size) {
+    cout << "class Wide {\n";
+
+    for (int i = 0; i < size; i++)
+        cout << "    f" << i << " : int32 <- " << i << ";\n";
+
+    for (int i = 0; i < size; i++)
+        cout << "    m" << i << "(x : int32) : int32 { f" << i << " <- x + f" << i << " }\n";
+
+    cout << "}\n"
+         << "class Main {\n"
+         << "    main() : int32 {\n"
+         << "        let w : Wide <- new Wide in {\n";
+
+    for (int i = 0; i < size; i++)
+        cout << "            w.m" << i << "(" << i % 7 << ");\n";
+
+    cout << "            printInt32(w.m" << size - 1 << "(0));\n"
+         << "            print(\"\\n\");\n"
+         << "            0\n"
+         << "        }\n"
+         << "    }\n"
+         << "}\n";
+}
+
+static void let(int size) {
+    cout << "class Main {\n"
+         << "    main() : int32 {\n"
+         << "        let x0 : int32 <- 0 in\n";
+
+    for (int i = 1; i < size; i++)
+        cout << "        let x" << i << " : int32 <- x" << i - 1 << " + " << i % 10 << " in\n";
+
+    cout << "        {\n"
+         << "            printInt32(x" << size - 1 << ");\n"
+         << "            print(\"\\n\");\n"
+         << "            0\n"
+         << "        }\n"
+         << "    }\n"
+         << "}\n";
+}
+
+static void expr(int size) {
+    static const char* const ops[] = {" + ", " - ", " * ", " / "};
+
+    cout << "class Main {\n"
+         << "    main() : int32 {\n"
+         << "        let x : int32 <- 7 in\n"
+         << "        let y : int32 <-\n"
+         << "            x";
+
+    // Divide only by literals different from 0
+    for (int i = 0; i < size; i++) {
+        cout << ops[i % 4];
+
+        if (i % 4 == 3)
+            cout << i % 9 + 1;
+        else if (i % 5 == 0)
+            cout << "(x" << ops[(i / 5) % 3] << i % 13 << ")";
+        else
+            cout << "x";
+
+        if (i % 8 == 7)
+            cout << "\n           ";
+    }
+
+    cout << "\n"
+         << "        in {\n"
+         << "            printInt32(y);\n"
+         << "            print(\"\\n\");\n"
+         << "            0\n"
+         << "        }\n"
+         << "    }\n"
+         << "}\n";
+}
+
+static void methods(int size) {
+    cout << "class Main {\n"
+         << "    m0(a : int32) : int32 { a }\n";
+
+    for (int i = 1; i < size; i++)
+        cout << "    m" << i << "(a : int32) : int32 { m" << i - 1 << "(a + " << i % 10 << ") }\n";
+
+    cout << "    main() : int32 {\n"
+         << "        printInt32(m" << size - 1 << "(0));\n"
+         << "        print(\"\\n\");\n"
+         << "        0\n"
+         << "    }\n"
+         << "}\n";
+}
+
+static const map<string, function<void(int)>> shapes = {
+    {"deep", deep},
+    {"wide", wide},
+    {"let", let},
+    {"expr", expr},
+    {"methods", methods}
+};
+
+int main(int argc, char const *argv[]) {
+    if (argc != 3 || shapes.count(argv[1]) == 0 || atoi(argv[2]) <= 0) {
+        cerr << "Usage: " << argv[0] << " <deep|wide|let|expr|methods> <size>" << endl;
+        return -1;
+    }
+
+    shapes.at(argv[1])(atoi(argv[2]));
+
+    return 0;
+}
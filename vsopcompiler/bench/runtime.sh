@@ -0,0 +1,93 @@
+#!/bin/bash
+#
+# Compile the runtime workloads of bench/runtime with vsopc -i, run them on
+# generated inputs and report their time, peak RSS and output checksum.
+#
+# The checksum must not change when the code generation or the runtime is
+# optimized, only the time and RSS should.
+#
+# Environment:
+#   VSOPC      compiler used to build the workloads (default: ./vsopc)
+#   WORKLOADS  workloads to run (default: alloc dispatch pow print input)
+#   SCALE      multiplier of the default workload sizes (default: 1)
+#   REPEAT     runs per workload, the best time is kept (default: 3)
+#   OUT        directory of the executables and inputs (default: bench/out/runtime)
+
+VSOPC=${VSOPC:-./vsopc}
+WORKLOADS=${WORKLOADS:-alloc dispatch pow print input}
+SCALE=${SCALE:-1}
+REPEAT=${REPEAT:-3}
+OUT=${OUT:-bench/out/runtime}
+
+mkdir -p "$OUT"
+
+# Default number of iterations of each workload
+size() {
+    case $1 in
+        alloc)    echo $((1000000 * SCALE)) ;;
+        dispatch) echo $((10000000 * SCALE)) ;;
+        pow)      echo $((2000000 * SCALE)) ;;
+        print)    echo $((1000000 * SCALE)) ;;
+        input)    echo $((500000 * SCALE)) ;;
+        *)        echo $((1000000 * SCALE)) ;;
+    esac
+}
+
+# Write the input of workload $1 with $2 iterations
+input() {
+    echo "$2"
+    if [ "$1" = input ]; then
+        awk -v n="$2" 'BEGIN {
+            for (i = 0; i < n; i++)
+                printf "%d the quick brown fox jumps over the lazy dog %d\n", i % 1000 - 500, i
+        }'
+    fi
+}
+
+# Time the last run with GNU time when available, for the peak RSS
+if /usr/bin/time -f "%e %M" true > /dev/null 2>&1; then
+    TIME="/usr/bin/time -f %e:%M -o $OUT/time"
+else
+    TIME=""
+fi
+
+printf "%-10s %10s %10s %12s %22s\n" workload size "time (s)" "rss (KiB)" cksum
+
+for workload in $WORKLOADS; do
+    n=$(size "$workload")
+    cp "bench/runtime/$workload.vsop" "$OUT/$workload.vsop"
+    input "$workload" "$n" > "$OUT/$workload.in"
+
+    # vsopc -i writes the executable next to the source file
+    rm -f "$OUT/$workload"
+    if ! "$VSOPC" -i "$OUT/$workload.vsop" > /dev/null || [ ! -x "$OUT/$workload" ]; then
+        printf "%-10s %10d %10s %12s %22s\n" "$workload" "$n" fail - -
+        continue
+    fi
+
+    best=""
+    rss=-
+    for ((r = 0; r < REPEAT; r++)); do
+        start=$(date +%s%N)
+        $TIME "$OUT/$workload" < "$OUT/$workload.in" > "$OUT/$workload.out"
+        status=$?
+        end=$(date +%s%N)
+
+        t=$(( (end - start) / 1000 ))
+        if [ -z "$best" ] || [ "$t" -lt "$best" ]; then
+            best=$t
+        fi
+        if [ -n "$TIME" ]; then
+            rss=$(tail -n 1 "$OUT/time" | cut -d: -f2)
+        fi
+    done
+
+    if [ "$status" -ne 0 ]; then
+        sum="exit $status"
+    else
+        sum=$(cksum < "$OUT/$workload.out" | awk '{ print $1 "/" $2 }')
+    fi
+
+    printf "%-10s %10d %10s %12s %22s\n" "$workload" "$n" \
+        "$(awk -v us="$best" 'BEGIN { printf "%.3f", us / 1e6 }')" "$rss" "$sum"
+done
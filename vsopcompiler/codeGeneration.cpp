@@ -1,7 +1,33 @@
 #include "codeGeneration.hpp"
 #include "ast.hpp"
+#include "stats.hpp"
 
-CodeGeneration::CodeGeneration(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes): classInfoMap_(classInfoMap), classMethodTypes_(classMethodTypes), classFieldTypes_(classFieldTypes), classMethodFormalsTypes_(classMethodFormalsTypes)
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+static const std::string runtimeSources = "/usr/local/lib/vsop/*.c";
+
+std::string CodeGeneration::runtimeDirectory_;
+std::string CodeGeneration::runtimeObjects_;
+
+// Run a shell command, its messages are written on std::cerr, which a
+// server reads, rather than on the standard error of the process
+static int runCommand(const std::string& command)
+{
+    FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+    if (!pipe)
+        return -1;
+
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+        std::cerr.write(buffer, n);
+
+    return pclose(pipe);
+}
+
+CodeGeneration::CodeGeneration(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes, const std::vector<std::string>& classOrder): classInfoMap_(classInfoMap), classMethodTypes_(classMethodTypes), classFieldTypes_(classFieldTypes), classMethodFormalsTypes_(classMethodFormalsTypes), classOrder_(classOrder), value_(nullptr)
 {
     auto& classNodeForFileName = classInfoMap_.at("Main").classNode;
     std::string currentFileName_ = classNodeForFileName->getFilename();
@@ -91,9 +117,7 @@ llvm::Type* CodeGeneration::getType(const std::string type)
 
 void CodeGeneration::declareStructuresAndVtables()
 {
-    for (const auto& classIt : classInfoMap_) {
-        const std::string& className = classIt.first;
-
+    for (const auto& className : classOrder_) {
         llvm::StructType::create(*llvmContext, className);
         
         llvm::StructType::create(*llvmContext, className + "__vtable");
@@ -109,13 +133,89 @@ void CodeGeneration::declareMallocFunction()
     createLLVMFunction(llvm::Type::getInt8PtrTy(*llvmContext), "malloc", argTypes);
 }
 
+// Integer exponentiation helper, by square-and-multiply with the wrapping
+// semantics of int32 multiplication. For a negative exponent, the exact result
+// truncated towards zero is returned (0 unless the base is 1 or -1).
 void CodeGeneration::declarePowerFunction()
 {
-    std::vector<llvm::Type *> argTypes;
-    argTypes.push_back(llvm::Type::getDoubleTy(*llvmContext));
-    argTypes.push_back(llvm::Type::getDoubleTy(*llvmContext));
+    llvm::Type* int32Type = getType("int32");
+    createLLVMFunction(int32Type, "power", {int32Type, int32Type});
+
+    llvm::Function* function = llvmModule->getFunction("power");
+    function->setLinkage(llvm::GlobalValue::InternalLinkage);
+    function->addFnAttr(llvm::Attribute::AlwaysInline);
+
+    auto argIt = function->arg_begin();
+    llvm::Value* base = &*argIt++;
+    llvm::Value* exponent = &*argIt;
+
+    auto entryBlock = llvm::BasicBlock::Create(*llvmContext, "entry", function);
+    auto negativeBlock = llvm::BasicBlock::Create(*llvmContext, "negative", function);
+    auto loopBlock = llvm::BasicBlock::Create(*llvmContext, "loop", function);
+    auto bodyBlock = llvm::BasicBlock::Create(*llvmContext, "body", function);
+    auto exitBlock = llvm::BasicBlock::Create(*llvmContext, "exit", function);
+
+    llvm::Value* zero = llvm::ConstantInt::get(int32Type, 0);
+    llvm::Value* one = llvm::ConstantInt::get(int32Type, 1);
+    llvm::Value* minusOne = llvm::ConstantInt::get(int32Type, -1, true);
+
+    // entry
+    llvmBuilder->SetInsertPoint(entryBlock);
+    llvmBuilder->CreateCondBr(llvmBuilder->CreateICmpSLT(exponent, zero), negativeBlock, loopBlock);
+
+    // negative: 1 ^ e = 1, (-1) ^ e = +/-1 depending on the parity of e, 0 otherwise
+    llvmBuilder->SetInsertPoint(negativeBlock);
+    llvm::Value* isOdd = llvmBuilder->CreateICmpNE(llvmBuilder->CreateAnd(exponent, one), zero);
+    llvm::Value* minusOneResult = llvmBuilder->CreateSelect(isOdd, minusOne, one);
+    llvm::Value* result = llvmBuilder->CreateSelect(llvmBuilder->CreateICmpEQ(base, minusOne), minusOneResult, zero);
+    result = llvmBuilder->CreateSelect(llvmBuilder->CreateICmpEQ(base, one), one, result);
+    llvmBuilder->CreateRet(result);
+
+    // loop
+    llvmBuilder->SetInsertPoint(loopBlock);
+    llvm::PHINode* accumulator = llvmBuilder->CreatePHI(int32Type, 2, "acc");
+    llvm::PHINode* square = llvmBuilder->CreatePHI(int32Type, 2, "square");
+    llvm::PHINode* remaining = llvmBuilder->CreatePHI(int32Type, 2, "remaining");
+    accumulator->addIncoming(one, entryBlock);
+    square->addIncoming(base, entryBlock);
+    remaining->addIncoming(exponent, entryBlock);
+    llvmBuilder->CreateCondBr(llvmBuilder->CreateICmpEQ(remaining, zero), exitBlock, bodyBlock);
+
+    // body: multiply the accumulator by the current square if the low bit is set
+    llvmBuilder->SetInsertPoint(bodyBlock);
+    llvm::Value* bitSet = llvmBuilder->CreateICmpNE(llvmBuilder->CreateAnd(remaining, one), zero);
+    llvm::Value* product = llvmBuilder->CreateMul(accumulator, square);
+    accumulator->addIncoming(llvmBuilder->CreateSelect(bitSet, product, accumulator), bodyBlock);
+    square->addIncoming(llvmBuilder->CreateMul(square, square), bodyBlock);
+    remaining->addIncoming(llvmBuilder->CreateLShr(remaining, one), bodyBlock);
+    llvmBuilder->CreateBr(loopBlock);
+
+    // exit
+    llvmBuilder->SetInsertPoint(exitBlock);
+    llvmBuilder->CreateRet(accumulator);
+}
 
-    createLLVMFunction(llvm::Type::getDoubleTy(*llvmContext), "pow", argTypes);
+// Multiply chain for base ^ exponent when the exponent is a non-negative
+// constant: floor(log2(exponent)) squarings plus one multiplication per set bit.
+llvm::Value* CodeGeneration::createPowerChain(llvm::Value* base, int32_t exponent)
+{
+    llvm::Value* result = nullptr;
+    llvm::Value* square = base;
+
+    while (exponent != 0) {
+        if (exponent & 1) {
+            result = result ? llvmBuilder->CreateMul(result, square) : square;
+        }
+        exponent >>= 1;
+        if (exponent != 0) {
+            square = llvmBuilder->CreateMul(square, square);
+        }
+    }
+
+    if (!result) {
+        return llvm::ConstantInt::get(getType("int32"), 1);
+    }
+    return result;
 }
 
 void CodeGeneration::declareObjectClassMethods()
@@ -161,10 +261,9 @@ void CodeGeneration::declareObjectClassMethods()
 
 void CodeGeneration::declareClassMethods()
 {
-    for (const auto& classIt : classMethodTypes_) {
-        const std::string& className = classIt.first;
-
-        if (className == "Object") {
+    for (const auto& className : classOrder_) {
+        auto methodsIt = classMethodTypes_.find(className);
+        if (className == "Object" || methodsIt == classMethodTypes_.end()) {
             continue;
         }
 
@@ -174,7 +273,7 @@ void CodeGeneration::declareClassMethods()
         // ___init
         createLLVMFunction(getType(className), className + "___init", {getType(className)});
 
-        for (const auto& it : classMethodTypes_.find(className)->second) {
+        for (const auto& it : methodsIt->second) {
             auto& methodName = it.first;
             auto& methodType = it.second;
 
@@ -204,9 +303,11 @@ void CodeGeneration::declareClassMethods()
 // verify if order of methods and types has importance
 void CodeGeneration::declareInheritedMethods()
 {
-    for (const auto& classIt : classMethodTypes_) {
-        std::string currentChildClass = classIt.first;
-        std::string currentClass = classInfoMap_.at(currentClass).parentClassName;
+    for (const auto& currentChildClass : classOrder_) {
+        if (classMethodTypes_.find(currentChildClass) == classMethodTypes_.end()) {
+            continue;
+        }
+        std::string currentClass = classInfoMap_.at(currentChildClass).parentClassName;
 
         if (currentClass == "Object") {
             continue;
@@ -257,8 +358,10 @@ void CodeGeneration::declareInheritedMethods()
 
 void CodeGeneration::declareInheritedFields()
 {
-    for (const auto& classIt : classFieldTypes_) {
-        const std::string& currentChildClass = classIt.first;
+    for (const auto& currentChildClass : classOrder_) {
+        if (classFieldTypes_.find(currentChildClass) == classFieldTypes_.end()) {
+            continue;
+        }
         const std::string& currentClass = classInfoMap_.at(currentChildClass).parentClassName;
 
         if (currentClass == "Object") {
@@ -298,6 +401,8 @@ void CodeGeneration::displayIROnStdout()
 
 void CodeGeneration::generateExecutable()
 {
+    stats.begin("emit");
+
     std::string execName = currentFileName_.substr(0, currentFileName_.find_last_of("."));
     std::ofstream exec(execName + ".ll");
     if(!exec) {
@@ -311,13 +416,47 @@ void CodeGeneration::generateExecutable()
     exec.close();
 
     // Execute command
-    std::string cmd = "clang -Wno-override-llvmModule -o " + execName + " " + execName + ".ll" + " /usr/local/lib/vsop/*.c";
-    int ret = system(cmd.c_str());
+    stats.begin("link");
+    std::string runtime = runtimeObjects_.empty() ? runtimeSources : runtimeObjects_;
+    std::string cmd = "clang -Wno-override-llvmModule -o " + execName + " " + execName + ".ll " + runtime;
+    int ret = runCommand(cmd);
     if(ret != 0) {
         std::cerr << "Error: Failed to execute clang command." << std::endl;
     }
 }
 
+void CodeGeneration::prebuildRuntime()
+{
+    char directory[] = "/tmp/vsopc-runtime-XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cerr << "Error: Failed to create the runtime directory." << std::endl;
+        return;
+    }
+
+    // Without the objects, the sources are still compiled at each link
+    std::string cmd = "cd " + std::string(directory) + " && clang -c " + runtimeSources;
+    runtimeDirectory_ = directory;
+
+    int ret = runCommand(cmd);
+    if(ret != 0) {
+        std::cerr << "Error: Failed to compile the runtime." << std::endl;
+        return;
+    }
+
+    runtimeObjects_ = runtimeDirectory_ + "/*.o";
+}
+
+void CodeGeneration::removeRuntime()
+{
+    if (runtimeDirectory_.empty())
+        return;
+
+    runCommand("rm -rf " + runtimeDirectory_);
+
+    runtimeDirectory_.clear();
+    runtimeObjects_.clear();
+}
+
 void CodeGeneration::cleanup() {
     llvmModule = nullptr;
 }
@@ -415,6 +554,38 @@ void CodeGeneration::visit(AST::FieldNode* node) {
     }
 }
 
+// PowNode --> ExprNode
+// Not reached yet: the method bodies and field initializers are not generated,
+// and only the integer literals among the operands set value_. The operands
+// are checked so that a missing lowering fails here rather than in the IR.
+void CodeGeneration::visit(AST::PowNode* node) {
+    value_ = nullptr;
+    node->getLeftExpr()->accept(this);
+    llvm::Value* base = value_;
+    assert(base != nullptr && "base of ^ not lowered");
+
+    // Constant non-negative exponent: no call, just a multiply chain
+    auto literal = dynamic_cast<AST::IntegerLiteralNode*>(node->getRightExpr());
+    if (literal != nullptr) {
+        int32_t exponent = literal->getValue();
+        if (exponent >= 0) {
+            value_ = createPowerChain(base, exponent);
+            return;
+        }
+    }
+
+    value_ = nullptr;
+    node->getRightExpr()->accept(this);
+    llvm::Value* exponent = value_;
+    assert(exponent != nullptr && "exponent of ^ not lowered");
+
+    value_ = llvmBuilder->CreateCall(llvmModule->getFunction("power"), {base, exponent});
+}
+
+void CodeGeneration::visit(AST::IntegerLiteralNode* node) {
+    value_ = llvm::ConstantInt::get(getType("int32"), node->getValue(), true);
+}
+
 // unused
 void CodeGeneration::visit(AST::TypeNode* /*node*/) {}
 void CodeGeneration::visit(AST::FormalNode* /*node*/) {}
@@ -433,7 +604,6 @@ void CodeGeneration::visit(AST::PlusNode* /*node*/) {}
 void CodeGeneration::visit(AST::MinusNode* /*node*/) {}
 void CodeGeneration::visit(AST::TimesNode* /*node*/) {}
 void CodeGeneration::visit(AST::DivNode* /*node*/) {}
-void CodeGeneration::visit(AST::PowNode* /*node*/) {}
 void CodeGeneration::visit(AST::UnaryExprNode* /*node*/) {}
 void CodeGeneration::visit(AST::UnaryMinusNode* /*node*/) {}
 void CodeGeneration::visit(AST::NotNode* /*node*/) {}
@@ -447,6 +617,5 @@ void CodeGeneration::visit(AST::BlockExprNode* /*node*/) {}
 void CodeGeneration::visit(AST::ArgsNode* /*node*/) {}
 void CodeGeneration::visit(AST::MethodNode* /*node*/) {}
 void CodeGeneration::visit(AST::CallExprNode* /*node*/) {}
-void CodeGeneration::visit(AST::IntegerLiteralNode* /*node*/) {}
 void CodeGeneration::visit(AST::LiteralNode* /*node*/) {}
 void CodeGeneration::visit(AST::BooleanLiteralNode* /*node*/) {}
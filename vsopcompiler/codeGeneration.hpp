@@ -24,7 +24,7 @@ class Program; // forward declaration of Program
 
 class CodeGeneration : public AST::Visitor {
 public:
-    CodeGeneration(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes);
+    CodeGeneration(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes, const std::vector<std::string>& classOrder);
 
     static CodeGeneration* getInstance(const std::string &fileName);
     void createLLVMFunction(llvm::Type* returnType, const std::string& functionName, const std::vector<llvm::Type*>& argTypes);
@@ -32,6 +32,8 @@ public:
     void declareStructuresAndVtables();
     void declareMallocFunction();
     void declarePowerFunction();
+    // Used by visit(PowNode) only, not reached yet
+    llvm::Value* createPowerChain(llvm::Value* base, int32_t exponent);
     void declareObjectClassMethods();
     void declareClassMethods();
     void declareInheritedMethods();
@@ -40,6 +42,13 @@ public:
     void generateExecutable();
     void cleanup();
 
+    // Compile the runtime once, the executables generated afterwards are
+    // linked with its objects instead of its sources
+    static void prebuildRuntime();
+
+    // Remove the objects built by prebuildRuntime()
+    static void removeRuntime();
+
     llvm::Type* getInt32TyW(llvm::LLVMContext* context);
     llvm::Type* getInt1TyW(llvm::LLVMContext* context);
     llvm::Type* getInt8PtrTyW(llvm::LLVMContext* context);
@@ -77,6 +86,7 @@ public:
     void visit(AST::MinusNode* node) override;
     void visit(AST::TimesNode* node) override;
     void visit(AST::DivNode* node) override;
+    // Not reached yet, method bodies are not generated: asserts its operands are lowered
     void visit(AST::PowNode* node) override;
     void visit(AST::NewExprNode* node) override;
     void visit(AST::VariableExprNode* node) override;
@@ -103,8 +113,18 @@ private:
     // Data structure to store class names, method names, formals names and their respective types
     const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes_;
 
+    // Classes each one after its parent, the layouts are declared in this order
+    const std::vector<std::string>& classOrder_;
+
     std::unordered_map<std::string, llvm::Type* (*)(llvm::LLVMContext*)> type_map_;
 
+    // Value computed by the last visited expression
+    llvm::Value* value_;
+
+    // Temporary directory of prebuildRuntime() and its objects, if any
+    static std::string runtimeDirectory_;
+    static std::string runtimeObjects_;
+
 };
 
 #endif // CODE_GENERATION_HPP
\ No newline at end of file
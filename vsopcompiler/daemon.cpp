@@ -0,0 +1,113 @@
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "daemon.hpp"
+
+using namespace std;
+using namespace VSOP;
+
+int Daemon::run(istream &in, ostream &out) {
+    string request;
+
+    while (getline(in, request)) {
+        if (request.empty())
+            continue;
+
+        if (request == "quit")
+            break;
+
+        // The error messages are written on the standard error, they are
+        // part of the answer
+        ostringstream messages;
+        streambuf *saved = cerr.rdbuf(messages.rdbuf());
+
+        auto start = chrono::steady_clock::now();
+        string result;
+        bool ok = handle(request, in, result);
+        auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start);
+
+        cerr.rdbuf(saved);
+
+        string lines = messages.str() + result;
+        size_t count = 0;
+        for (char c : lines)
+            count += c == '\n';
+
+        out << (ok ? "ok " : "error ") << count << " " << elapsed.count() << "\n" << lines;
+        out.flush();
+    }
+
+    return 0;
+}
+
+bool Daemon::handle(const string &request, istream &in, string &result) {
+    istringstream words(request);
+    string command, file;
+    words >> command >> file;
+
+    if (command == "open") {
+        ifstream stream(file, ios::binary);
+        if (!stream) {
+            cerr << "cannot open " << file << "\n";
+            return false;
+        }
+
+        ostringstream source;
+        source << stream.rdbuf();
+
+        documents[file].reset(new Document(file, source.str()));
+
+        return documents[file]->check(cerr) == 0;
+    }
+
+    auto document = documents.find(file);
+    if (document == documents.end()) {
+        cerr << "invalid request: " << request << "\n";
+        return false;
+    }
+
+    if (command == "edit") {
+        size_t offset, removed, length;
+        if (!(words >> offset >> removed >> length)) {
+            cerr << "invalid request: " << request << "\n";
+            return false;
+        }
+
+        string text(length, '\0');
+        in.read(&text[0], length);
+        if ((size_t) in.gcount() != length) {
+            cerr << "truncated request: " << request << "\n";
+            return false;
+        }
+
+        const string &source = document->second->get_source();
+        if (offset > source.size() || removed > source.size() - offset) {
+            cerr << "invalid range: " << request << "\n";
+            return false;
+        }
+
+        document->second->edit(offset, removed, text);
+
+        return true;
+    }
+
+    if (command == "check")
+        return document->second->check(cerr) == 0;
+
+    if (command == "print") {
+        if (document->second->check(cerr) != 0)
+            return false;
+
+        result = document->second->get_program()->evaluate() + "\n";
+        return true;
+    }
+
+    if (command == "close") {
+        documents.erase(document);
+        return true;
+    }
+
+    cerr << "invalid request: " << request << "\n";
+    return false;
+}
@@ -0,0 +1,60 @@
+#ifndef _DAEMON_HPP
+#define _DAEMON_HPP
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "document.hpp"
+
+namespace VSOP {
+    /**
+     * @brief Keeps source files in memory, to check them again after each
+     * edit without running the whole compiler.
+     *
+     * The requests are read one per line:
+     *
+     *     open <file>                                   read and check a file
+     *     edit <file> <offset> <removed> <length>       replace a range of a file
+     *                                                   by the <length> bytes following the line
+     *     check <file>                                  check a file
+     *     print <file>                                  check a file and print its typed AST
+     *     close <file>                                  forget a file
+     *     quit
+     *
+     * Each request is answered by a line "ok|error <count> <microseconds>",
+     * followed by <count> lines: the error messages, or the AST.
+     */
+    class Daemon {
+        public:
+            /**
+             * @brief Answer the requests until the end of the input or quit.
+             *
+             * @param in The requests.
+             * @param out The answers.
+             *
+             * @return int The exit code.
+             */
+            int run(std::istream &in, std::ostream &out);
+
+        private:
+            /**
+             * @brief The open files, by name.
+             */
+            std::map<std::string, std::unique_ptr<Document>> documents;
+
+            /**
+             * @brief Handle a request.
+             *
+             * @param request The line of the request.
+             * @param in The input, for the text of an edit.
+             * @param result Receives the lines of the answer.
+             *
+             * @return bool true on success.
+             */
+            bool handle(const std::string &request, std::istream &in, std::string &result);
+    };
+}
+
+#endif
@@ -0,0 +1,676 @@
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include "document.hpp"
+#include "utils.hpp"
+
+using namespace std;
+using namespace VSOP;
+
+/**
+ * @brief Discards the errors of a driver while it exists.
+ *
+ * The errors found while lexing or parsing a part of the source are
+ * reported by the lexer or parser run on the whole source instead.
+ */
+class Silence {
+    public:
+        Silence(Driver &driver) : driver(driver), saved(driver.get_errors()) {
+            driver.set_errors(discarded);
+        }
+
+        ~Silence() { driver.set_errors(saved); }
+
+    private:
+        Driver &driver;
+        ostringstream discarded;
+        ostream &saved;
+};
+
+/**
+ * @brief Get the declaration of a class, the other classes only depend on it.
+ */
+static string signature(AST::ClassNode *node) {
+    string s = node->getName() + " " + (node->getParent().empty() ? "Object" : node->getParent()) + " {";
+
+    for (AST::FieldNode *field : node->getClassBody()->getFields())
+        s += " " + field->getName() + " : " + field->getType()->getTypeStr() + ";";
+
+    for (AST::MethodNode *method : node->getClassBody()->getMethods()) {
+        s += " " + method->getName() + "(";
+
+        for (AST::FormalNode *formal : method->getFormals()->getFormals())
+            s += formal->getName() + " : " + formal->getType()->getTypeStr() + ",";
+
+        s += ") : " + method->getRetType()->getTypeStr() + ";";
+    }
+
+    return s + " }";
+}
+
+/**
+ * @brief Check if a member depends on a changed declaration.
+ */
+static bool depends(const unordered_set<string> &dependencies, const unordered_set<string> &changed) {
+    for (const string &name : dependencies) {
+        if (changed.count(name))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Get the members of a class by name, or nullptr for the names
+ * given to several members.
+ */
+template <typename T>
+static unordered_map<string, T*> by_name(const vector<T*> &members) {
+    unordered_map<string, T*> result;
+
+    for (T *member : members) {
+        auto inserted = result.emplace(member->getName(), member);
+        if (!inserted.second)
+            inserted.first->second = nullptr;
+    }
+
+    return result;
+}
+
+Document::Document(const string &source_file, string source)
+: driver(source_file), lexed(false), parsed(false), declared(false), program(nullptr), object(nullptr) {
+    driver.set_source(std::move(source));
+}
+
+Document::~Document() {
+    clear();
+}
+
+void Document::edit(size_t offset, size_t removed, const string &text) {
+    if (!lexed) {
+        string source = driver.get_source();
+        source.replace(offset, removed, text);
+        driver.set_source(std::move(source));
+        return;
+    }
+
+    Silence silence(driver);
+    TokenEdit change;
+
+    if (driver.edit(offset, removed, text, change) != 0) {
+        lexed = false;
+        return;
+    }
+
+    if (parsed)
+        damage(change);
+}
+
+void Document::damage(const TokenEdit &change) {
+    if (change.begin == change.old_end && change.begin == change.new_end)
+        return;
+
+    ptrdiff_t delta = (ptrdiff_t) change.new_end - (ptrdiff_t) change.old_end;
+
+    // Spans overlapping the replaced tokens, or containing the inserted ones
+    size_t first = 0;
+    while (first < spans.size() && spans[first].end <= change.begin)
+        first++;
+
+    size_t last = first;
+    while (last < spans.size() && spans[last].begin < change.old_end)
+        last++;
+
+    Span merged = {change.begin, change.new_end, true, false, {}, {}, {}};
+
+    if (first < last) {
+        merged.begin = spans[first].begin;
+        merged.end = spans[last - 1].end + delta;
+
+        for (size_t i = first; i < last; i++) {
+            Span &span = spans[i];
+
+            // The members containing replaced tokens must be checked again
+            for (map<string, Member> &members : span.members) {
+                for (auto &entry : members) {
+                    Member &member = entry.second;
+
+                    if (member.begin < change.old_end && change.begin < member.end) {
+                        member.checked = false;
+                    } else if (member.begin >= change.old_end) {
+                        member.begin += delta;
+                        member.end += delta;
+                    }
+                }
+            }
+
+            merged.classes.insert(merged.classes.end(), span.classes.begin(), span.classes.end());
+            merged.signatures.insert(merged.signatures.end(), span.signatures.begin(), span.signatures.end());
+            merged.members.insert(merged.members.end(), span.members.begin(), span.members.end());
+        }
+    }
+
+    for (size_t i = last; i < spans.size(); i++) {
+        spans[i].begin += delta;
+        spans[i].end += delta;
+
+        for (map<string, Member> &members : spans[i].members) {
+            for (auto &entry : members) {
+                entry.second.begin += delta;
+                entry.second.end += delta;
+            }
+        }
+    }
+
+    spans.erase(spans.begin() + first, spans.begin() + last);
+    spans.insert(spans.begin() + first, std::move(merged));
+}
+
+int Document::check(ostream &errors) {
+    driver.set_errors(errors);
+    int res = check_source();
+
+    // The stream can be gone by the next edit
+    driver.set_errors(cerr);
+
+    return res;
+}
+
+int Document::check_source() {
+    if (!lexed) {
+        if (driver.lex_source() != 0)
+            return 1;
+
+        lexed = true;
+        parsed = false;
+    }
+
+    bool redeclare = !declared;
+    unordered_set<AST::ClassNode*> reparsed;
+
+    // Without classes, the syntax error is reported by the parser
+    if (parsed && !(reparse(redeclare, reparsed) && !spans.empty()))
+        parsed = false;
+
+    bool fresh = !parsed;
+
+    if (!parsed) {
+        if (!parse())
+            return 1;
+
+        parsed = true;
+        redeclare = true;
+    }
+
+    if (redeclare) {
+        int res;
+        {
+            // The classes kept can be after lines added or removed around
+            // their tokens, their errors are reported after a full parse
+            unique_ptr<Silence> silence(fresh ? nullptr : new Silence(driver));
+            res = declare();
+        }
+
+        if (res != 0 && !fresh) {
+            if (!parse())
+                return 1;
+
+            res = declare();
+        }
+
+        if (res != 0)
+            return 1;
+    } else if (redeclare_classes(reparsed) != 0) {
+        return 1;
+    }
+
+    return check_members();
+}
+
+bool Document::parse() {
+    clear();
+
+    if (driver.parse() != 0)
+        return false;
+
+    program = driver.res;
+    object = program->getClasses()[0];
+
+    return split(0, driver.get_token_count(), program, spans);
+}
+
+bool Document::reparse(bool &redeclare, unordered_set<AST::ClassNode*> &reparsed) {
+    // The spans parsed again, by index
+    map<size_t, vector<Span>> parsed_spans;
+
+    auto discard = [&parsed_spans]() {
+        for (auto &entry : parsed_spans) {
+            for (Span &part : entry.second)
+                delete part.classes[0];
+        }
+    };
+
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (!spans[i].dirty)
+            continue;
+
+        vector<Span> &parts = parsed_spans[i];
+        if (!parse_span(spans[i], parts)) {
+            discard();
+            return false;
+        }
+
+        vector<string> signatures;
+        for (const Span &part : parts)
+            signatures.push_back(part.signatures[0]);
+
+        if (signatures != spans[i].signatures)
+            redeclare = true;
+    }
+
+    unordered_set<string> changed;
+
+    if (redeclare) {
+        changed = changed_declarations(parsed_spans);
+
+        // The checked members depending on a changed declaration are
+        // parsed and checked again
+        for (size_t i = 0; i < spans.size(); i++) {
+            if (spans[i].dirty)
+                continue;
+
+            bool affected = false;
+            for (map<string, Member> &members : spans[i].members) {
+                for (auto &entry : members) {
+                    Member &member = entry.second;
+
+                    if (member.checked && depends(member.dependencies, changed)) {
+                        member.checked = false;
+                        affected = true;
+                    }
+                }
+            }
+
+            if (!affected)
+                continue;
+
+            spans[i].checked = false;
+
+            if (!parse_span(spans[i], parsed_spans[i])) {
+                discard();
+                return false;
+            }
+        }
+    }
+
+    // The replaced classes by name, the members of the classes with the
+    // same name keep their check
+    unordered_map<string, pair<AST::ClassNode*, map<string, Member>*>> previous;
+    unordered_set<string> ambiguous;
+
+    for (auto &entry : parsed_spans) {
+        Span &span = spans[entry.first];
+
+        for (size_t j = 0; j < span.classes.size(); j++) {
+            const string &name = span.classes[j]->getName();
+            if (!previous.emplace(name, make_pair(span.classes[j], &span.members[j])).second)
+                ambiguous.insert(name);
+        }
+    }
+
+    vector<Span> updated;
+    unordered_set<string> names;
+
+    for (size_t i = 0; i < spans.size(); i++) {
+        auto entry = parsed_spans.find(i);
+        if (entry == parsed_spans.end()) {
+            updated.push_back(std::move(spans[i]));
+            continue;
+        }
+
+        for (Span &part : entry->second) {
+            AST::ClassNode *node = part.classes[0];
+
+            auto old = previous.find(node->getName());
+            if (!names.insert(node->getName()).second)
+                ambiguous.insert(node->getName());
+            else if (old != previous.end() && !ambiguous.count(node->getName()))
+                adopt(part, old->second.first, *old->second.second, changed);
+
+            reparsed.insert(node);
+            updated.push_back(std::move(part));
+        }
+
+        for (AST::ClassNode *node : spans[i].classes)
+            delete node;
+    }
+
+    spans = std::move(updated);
+
+    // Object, then the classes from the last one, as built by the parser
+    vector<AST::ClassNode*> classes = {object};
+    for (auto span = spans.rbegin(); span != spans.rend(); ++span)
+        classes.push_back(span->classes[0]);
+
+    program->setClasses(classes);
+
+    return true;
+}
+
+bool Document::parse_span(const Span &span, vector<Span> &parts) {
+    if (span.begin == span.end)
+        return true;
+
+    int res;
+    {
+        Silence silence(driver);
+        res = driver.parse(span.begin, span.end);
+    }
+
+    if (res != 0)
+        return false;
+
+    bool ok = split(span.begin, span.end, driver.res, parts);
+
+    // Only the classes of the span are kept
+    const vector<AST::ClassNode*> &classes = driver.res->getClasses();
+    if (!ok) {
+        for (size_t i = 1; i < classes.size(); i++)
+            delete classes[i];
+    }
+
+    delete classes[0];
+    delete driver.res;
+
+    return ok;
+}
+
+void Document::adopt(Span &part, AST::ClassNode *previous, map<string, Member> &members,
+                     const unordered_set<string> &changed) {
+    AST::ClassBodyNode *body = part.classes[0]->getClassBody();
+    AST::ClassBodyNode *previous_body = previous->getClassBody();
+
+    // A member keeps its check if it has the same tokens, and none of its
+    // dependencies changed
+    auto keep = [&](const string &key) -> Member * {
+        auto old = members.find(key);
+        auto now = part.members[0].find(key);
+
+        if (old == members.end() || now == part.members[0].end())
+            return nullptr;
+
+        if (!old->second.checked || old->second.begin != now->second.begin || old->second.end != now->second.end
+            || depends(old->second.dependencies, changed))
+            return nullptr;
+
+        now->second.checked = true;
+        now->second.dependencies = std::move(old->second.dependencies);
+
+        return &now->second;
+    };
+
+    unordered_map<string, AST::FieldNode*> fields = by_name(body->getFields());
+    unordered_map<string, AST::FieldNode*> previous_fields = by_name(previous_body->getFields());
+
+    for (auto &entry : fields) {
+        auto old = previous_fields.find(entry.first);
+        if (!entry.second || old == previous_fields.end() || !old->second || !keep("field " + entry.first))
+            continue;
+
+        // The replaced class is deleted with the initializer just parsed
+        AST::ExprNode *init_expr = entry.second->getInitExpr();
+        entry.second->setInitExpr(old->second->getInitExpr());
+        old->second->setInitExpr(init_expr);
+    }
+
+    unordered_map<string, AST::MethodNode*> methods = by_name(body->getMethods());
+    unordered_map<string, AST::MethodNode*> previous_methods = by_name(previous_body->getMethods());
+
+    for (auto &entry : methods) {
+        auto old = previous_methods.find(entry.first);
+        if (!entry.second || old == previous_methods.end() || !old->second || !keep("method " + entry.first))
+            continue;
+
+        AST::BlockNode *block = entry.second->getBlock();
+        entry.second->setBlock(old->second->getBlock());
+        old->second->setBlock(block);
+    }
+
+    part.checked = true;
+    for (const auto &entry : part.members[0])
+        part.checked = part.checked && entry.second.checked;
+}
+
+bool Document::split(size_t begin, size_t end, const AST::ProgramNode *result, vector<Span> &out) {
+    const TokenStore &tokens = driver.get_tokens();
+    const vector<AST::ClassNode*> &classes = result->getClasses();
+
+    // A class starts with the only class keyword outside braces
+    vector<size_t> starts;
+    int depth = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        switch (tokens.kind(i)) {
+            case Parser::token::LBRACE: depth++; break;
+            case Parser::token::RBRACE: depth--; break;
+            case Parser::token::CLASS:
+                if (depth == 0)
+                    starts.push_back(i);
+                break;
+            default: break;
+        }
+    }
+
+    if (starts.size() != classes.size() - 1)
+        return false;
+
+    for (size_t i = 0; i < starts.size(); i++) {
+        AST::ClassNode *node = classes[classes.size() - 1 - i];
+        size_t next = i + 1 < starts.size() ? starts[i + 1] : end;
+
+        // A member starts with an identifier in the class body, a field ends
+        // with a semicolon and a method with the brace closing its body
+        map<string, Member> members;
+        size_t member = next;
+        string key;
+        depth = 0;
+
+        for (size_t j = starts[i]; j < next; j++) {
+            switch (tokens.kind(j)) {
+                case Parser::token::OBJECT_IDENTIFIER:
+                    if (depth == 1 && member == next) {
+                        bool method = j + 1 < next && tokens.kind(j + 1) == Parser::token::LPAR;
+                        member = j;
+                        key = (method ? "method " : "field ") + string(tokens.lexeme(j), tokens.length(j));
+                    }
+                    break;
+
+                case Parser::token::LBRACE:
+                    depth++;
+                    break;
+
+                case Parser::token::RBRACE:
+                    if (--depth == 1 && member != next) {
+                        members[key] = {member, j + 1, false, {}};
+                        member = next;
+                    }
+                    break;
+
+                case Parser::token::SEMICOLON:
+                    if (depth == 1 && member != next) {
+                        members[key] = {member, j + 1, false, {}};
+                        member = next;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        out.push_back({starts[i], next, false, false, {node}, {signature(node)}, {std::move(members)}});
+    }
+
+    return true;
+}
+
+unordered_set<string> Document::changed_declarations(const map<size_t, vector<Span>> &parsed) const {
+    unordered_map<string, string> current;
+    unordered_set<string> changed;
+
+    for (size_t i = 0; i < spans.size(); i++) {
+        auto entry = parsed.find(i);
+        const vector<Span> &parts = entry != parsed.end() ? entry->second : vector<Span>(1, spans[i]);
+
+        for (const Span &part : parts) {
+            for (size_t j = 0; j < part.classes.size(); j++) {
+                // A class defined twice
+                if (!current.emplace(part.classes[j]->getName(), part.signatures[j]).second)
+                    changed.insert(part.classes[j]->getName());
+            }
+        }
+    }
+
+    for (const auto &entry : current) {
+        auto declaration = declarations.find(entry.first);
+        if (declaration == declarations.end() || declaration->second != entry.second)
+            changed.insert(entry.first);
+    }
+
+    for (const auto &entry : declarations) {
+        if (!current.count(entry.first))
+            changed.insert(entry.first);
+    }
+
+    return changed;
+}
+
+int Document::declare() {
+    declared = false;
+
+    try {
+        firstPass.reset(new FirstPass());
+        program->accept(firstPass.get());
+
+        secondPass.reset(new SecondPass(firstPass->getClassInfoMap()));
+        program->accept(secondPass.get());
+
+        thirdPass.reset(new ThirdPass(firstPass->getClassInfoMap(), secondPass->getClassMethodTypes(), secondPass->getClassFieldTypes()));
+        program->accept(thirdPass.get());
+
+        fourthPass.reset(new FourthPass(firstPass->getClassInfoMap(), secondPass->getClassMethodTypes(), secondPass->getClassFieldTypes(), thirdPass->getClassMethodFormalTypes(), types));
+        object->accept(fourthPass.get());
+
+    } catch (const SemanticError &e) {
+        driver.get_errors() << e.message << flush;
+        return 1;
+    }
+
+    declarations.clear();
+    for (const Span &span : spans) {
+        for (size_t j = 0; j < span.classes.size(); j++)
+            declarations[span.classes[j]->getName()] = span.signatures[j];
+    }
+
+    declared = true;
+
+    return 0;
+}
+
+int Document::redeclare_classes(const unordered_set<AST::ClassNode*> &reparsed) {
+    // The tables must refer to the new classes before any is checked
+    for (Span &span : spans) {
+        if (!span.checked || reparsed.count(span.classes[0]))
+            firstPass->updateClass(span.classes[0]);
+    }
+
+    // Same order as ThirdPass on the program
+    for (auto span = spans.rbegin(); span != spans.rend(); ++span) {
+        if (span->checked && !reparsed.count(span->classes[0]))
+            continue;
+
+        try {
+            thirdPass->recheckClass(span->classes[0]);
+        } catch (const SemanticError &e) {
+            driver.get_errors() << e.message << flush;
+            span->dirty = true;
+            span->checked = false;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int Document::check_members() {
+    // Same order as FourthPass on the program: the fields, then the methods
+    // of each class
+    for (auto span = spans.rbegin(); span != spans.rend(); ++span) {
+        if (span->checked)
+            continue;
+
+        for (size_t i = 0; i < span->classes.size(); i++) {
+            AST::ClassNode *node = span->classes[i];
+            map<string, Member> &members = span->members[i];
+
+            // As FourthPass on a class, even if all its members were kept
+            node->setType(AST::Type::CLASS);
+
+            try {
+                for (AST::FieldNode *field : node->getClassBody()->getFields()) {
+                    Member &member = members["field " + field->getName()];
+                    if (member.checked)
+                        continue;
+
+                    member.dependencies.clear();
+                    fourthPass->checkField(node, field, member.dependencies);
+                    member.checked = true;
+                }
+
+                for (AST::MethodNode *method : node->getClassBody()->getMethods()) {
+                    Member &member = members["method " + method->getName()];
+                    if (member.checked)
+                        continue;
+
+                    member.dependencies.clear();
+                    fourthPass->checkMethod(node, method, member.dependencies);
+                    member.checked = true;
+                }
+            } catch (const SemanticError &e) {
+                driver.get_errors() << e.message << flush;
+                // Partly checked, it is parsed again by the next check
+                span->dirty = true;
+                return 1;
+            }
+        }
+
+        span->checked = true;
+    }
+
+    return 0;
+}
+
+void Document::clear() {
+    fourthPass.reset();
+    thirdPass.reset();
+    secondPass.reset();
+    firstPass.reset();
+
+    declared = false;
+
+    for (const Span &span : spans) {
+        for (AST::ClassNode *node : span.classes)
+            delete node;
+    }
+
+    spans.clear();
+
+    delete object;
+    delete program;
+
+    object = nullptr;
+    program = nullptr;
+}
@@ -0,0 +1,262 @@
+#ifndef _DOCUMENT_HPP
+#define _DOCUMENT_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <memory>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "driver.hpp"
+#include "ast.hpp"
+#include "firstPass.hpp"
+#include "secondPass.hpp"
+#include "thirdPass.hpp"
+#include "fourthPass.hpp"
+
+namespace VSOP {
+    /**
+     * @brief A source file kept in memory between edits, with its tokens,
+     * its AST and the tables of the semantic passes.
+     *
+     * An edit only lexes again the tokens it changed and marks the fields
+     * and methods containing them. A check parses again the classes of the
+     * marked fields and methods, and FourthPass checks them again. The
+     * other fields and methods keep their checked initializer or body.
+     *
+     * The check of each field and method records the classes whose
+     * declaration (parent, fields, methods and formals) it depends on. When
+     * declarations change, FirstPass to ThirdPass run again on the whole
+     * program, and FourthPass only on the fields and methods depending on
+     * the changed declarations.
+     */
+    class Document {
+        public:
+            /**
+             * @brief Construct a new Document.
+             *
+             * @param source_file The name of the file, used in the messages.
+             * @param source The source code.
+             */
+            Document(const std::string &source_file, std::string source);
+
+            ~Document();
+
+            Document(const Document &) = delete;
+            Document &operator=(const Document &) = delete;
+
+            /**
+             * @brief Get the source code.
+             */
+            const std::string &get_source() const { return driver.get_source(); }
+
+            /**
+             * @brief Replace a range of the source code.
+             *
+             * @param offset The offset of the range.
+             * @param removed The length of the range.
+             * @param text The text replacing the range.
+             */
+            void edit(std::size_t offset, std::size_t removed, const std::string &text);
+
+            /**
+             * @brief Check the source code.
+             *
+             * @param errors The stream of the errors.
+             *
+             * @return int 0 if no lexical, syntax or semantic error.
+             */
+            int check(std::ostream &errors);
+
+            /**
+             * @brief Get the AST of the last successful check.
+             */
+            AST::ProgramNode *get_program() const { return program; }
+
+        private:
+            /**
+             * @brief The tokens of a field or a method.
+             */
+            struct Member {
+                std::size_t begin;
+                std::size_t end;
+
+                /**
+                 * @brief Checked by FourthPass with the current tables.
+                 */
+                bool checked;
+
+                /**
+                 * @brief The classes whose declaration the check depends on.
+                 */
+                std::unordered_set<std::string> dependencies;
+            };
+
+            /**
+             * @brief The tokens of consecutive classes of the source.
+             *
+             * A clean span holds the single class parsed from its tokens. A
+             * dirty span must be parsed again, it holds the classes parsed
+             * before its tokens changed, if any.
+             */
+            struct Span {
+                std::size_t begin;
+                std::size_t end;
+                bool dirty;
+
+                /**
+                 * @brief All the members of its classes are checked.
+                 */
+                bool checked;
+
+                std::vector<AST::ClassNode*> classes;
+                std::vector<std::string> signatures;
+
+                /**
+                 * @brief The members of each class, by kind and name.
+                 */
+                std::vector<std::map<std::string, Member>> members;
+            };
+
+            Driver driver;
+
+            /**
+             * @brief The tokens match the source.
+             */
+            bool lexed;
+
+            /**
+             * @brief The spans match the tokens.
+             */
+            bool parsed;
+
+            /**
+             * @brief The tables of FirstPass to ThirdPass were built from the
+             * declarations.
+             */
+            bool declared;
+
+            /**
+             * @brief The declarations of the classes when the tables were built.
+             */
+            std::unordered_map<std::string, std::string> declarations;
+
+            /**
+             * @brief The spans of the classes, covering all the tokens.
+             */
+            std::vector<Span> spans;
+
+            AST::ProgramNode *program;
+            AST::ClassNode *object;
+
+            /**
+             * @brief The types of the expressions, named in this document
+             * only. The kept members refer to it across the checks.
+             */
+            AST::TypeTable types;
+
+            std::unique_ptr<FirstPass> firstPass;
+            std::unique_ptr<SecondPass> secondPass;
+            std::unique_ptr<ThirdPass> thirdPass;
+            std::unique_ptr<FourthPass> fourthPass;
+
+            /**
+             * @brief Mark dirty the spans containing tokens changed by an edit.
+             */
+            void damage(const TokenEdit &change);
+
+            /**
+             * @brief Check the source code, the errors are printed on the
+             * stream of the driver.
+             *
+             * @return int 0 if no lexical, syntax or semantic error.
+             */
+            int check_source();
+
+            /**
+             * @brief Parse all the tokens again.
+             *
+             * @return bool true if no syntax error.
+             */
+            bool parse();
+
+            /**
+             * @brief Parse the dirty spans again, and the spans with members
+             * depending on changed declarations.
+             *
+             * @param redeclare Set to true if the declarations changed.
+             * @param reparsed Receives the classes parsed again.
+             *
+             * @return bool true if no syntax error.
+             */
+            bool reparse(bool &redeclare, std::unordered_set<AST::ClassNode*> &reparsed);
+
+            /**
+             * @brief Parse the tokens of a span.
+             *
+             * @return bool true if there is a span for each class.
+             */
+            bool parse_span(const Span &span, std::vector<Span> &parts);
+
+            /**
+             * @brief Move the checked members of a class replaced by a span
+             * parsed again to its new class.
+             *
+             * @param part The span parsed again.
+             * @param previous The replaced class.
+             * @param members The members of the replaced class.
+             * @param changed The classes whose declaration changed.
+             */
+            void adopt(Span &part, AST::ClassNode *previous, std::map<std::string, Member> &members,
+                       const std::unordered_set<std::string> &changed);
+
+            /**
+             * @brief Split the tokens of parsed classes in spans.
+             *
+             * @return bool true if there is a span for each class.
+             */
+            bool split(std::size_t begin, std::size_t end, const AST::ProgramNode *result,
+                       std::vector<Span> &out);
+
+            /**
+             * @brief Get the classes whose declaration changed since the tables
+             * were built.
+             *
+             * @param parsed The spans parsed again, replacing the spans at their index.
+             */
+            std::unordered_set<std::string> changed_declarations(
+                const std::map<std::size_t, std::vector<Span>> &parsed) const;
+
+            /**
+             * @brief Run FirstPass to ThirdPass on the program.
+             *
+             * @return int 0 if no semantic error.
+             */
+            int declare();
+
+            /**
+             * @brief Run ThirdPass again on the classes parsed again and the
+             * classes not checked, with the same declarations.
+             *
+             * @return int 0 if no semantic error.
+             */
+            int redeclare_classes(const std::unordered_set<AST::ClassNode*> &reparsed);
+
+            /**
+             * @brief Run FourthPass on the members not checked.
+             *
+             * @return int 0 if no semantic error.
+             */
+            int check_members();
+
+            /**
+             * @brief Delete the AST and the tables.
+             */
+            void clear();
+    };
+}
+
+#endif
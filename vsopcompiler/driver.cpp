@@ -1,17 +1,40 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <string>
-#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "driver.hpp"
+#include "fastParser.hpp"
 #include "parser.hpp"
+#include "scanner.hpp"
 
 using namespace std;
 using namespace VSOP;
 
 /**
- * @brief Map a token type to a string.
+ * @brief The smallest source lexed in several chunks, and the smallest
+ * size of a chunk.
  */
-static const map<Parser::token_type, string> type_to_string = {
+static const size_t min_chunk_size = 1 << 20;
+
+/**
+ * @brief A token and its name.
+ */
+struct TokenName {
+    Parser::token_type token;
+    const char *name;
+};
+
+static constexpr TokenName token_name_list[] = {
     {Parser::token::INTEGER_LITERAL, "integer-literal"},
 
     {Parser::token::AND, "and"},
@@ -63,95 +86,551 @@ static const map<Parser::token_type, string> type_to_string = {
 };
 
 /**
- * @brief Print the information about a token
+ * @brief The names of the tokens, indexed by token kind.
+ */
+struct TokenNames {
+    const char *names[Parser::symbol_kind::YYNTOKENS];
+};
+
+static constexpr TokenNames make_token_names() {
+    TokenNames table = {};
+
+    for (const TokenName &token_name : token_name_list)
+        table.names[token_name.token] = token_name.name;
+
+    return table;
+}
+
+static constexpr TokenNames token_names = make_token_names();
+
+/**
+ * @brief Buffered writer of the tokens on the standard output.
  *
- * @param token the token
+ * The lines are written in a single preallocated buffer, which is only
+ * flushed between two lines, when it is full, and at the end.
  */
-static void print_token(Parser::symbol_type token) {
-    position pos = token.location.begin;
-    Parser::token_type type = (Parser::token_type)token.type_get();
-
-    cout << pos.line << ","
-         << pos.column << ","
-         << type_to_string.at(type);
-
-    switch (type) {
-        case Parser::token::INTEGER_LITERAL: {
-            int value = token.value.as<int>();
-            cout << "," << value;
-            break;
+class TokenWriter {
+    public:
+        TokenWriter() : buffer(capacity), size(0) {}
+
+        ~TokenWriter() { flush(); }
+
+        /**
+         * @brief Write the information about a token.
+         *
+         * @param tokens the token store
+         * @param i the index of the token
+         */
+        void write(const TokenStore &tokens, size_t i) {
+            Parser::token_type type = tokens.kind(i);
+            const char *payload = nullptr;
+            size_t payload_length = 0;
+
+            switch (type) {
+                case Parser::token::TYPE_IDENTIFIER:
+                case Parser::token::OBJECT_IDENTIFIER:
+                    payload = tokens.lexeme(i);
+                    payload_length = tokens.length(i);
+                    break;
+
+                case Parser::token::STRING_LITERAL:
+                    tokens.string_literal(i, scratch);
+                    payload = scratch.data();
+                    payload_length = scratch.size();
+                    break;
+
+                default:
+                    break;
+            }
+
+            // Keep the whole line in the buffer
+            if (capacity - size < max_line_length + payload_length)
+                flush();
+
+            append_int(tokens.line(i));
+            append(',');
+            append_int(tokens.column(i));
+            append(',');
+            append(token_names.names[type]);
+
+            switch (type) {
+                case Parser::token::INTEGER_LITERAL:
+                    append(',');
+                    append_int(tokens.integer(i));
+                    break;
+
+                case Parser::token::TYPE_IDENTIFIER:
+                case Parser::token::OBJECT_IDENTIFIER:
+                    append(',');
+                    append(payload, payload_length);
+                    break;
+
+                case Parser::token::STRING_LITERAL:
+                    append(",\"", 2);
+                    append(payload, payload_length);
+                    append('"');
+                    break;
+
+                default:
+                    break;
+            }
+
+            append('\n');
         }
 
-        case Parser::token::TYPE_IDENTIFIER: {
-            string id = token.value.as<string>();
-            cout << "," << id;
-            break;
+        /**
+         * @brief Write the content of the buffer on the standard output.
+         */
+        void flush() {
+            cout.write(buffer.data(), size);
+            cout.flush();
+            size = 0;
         }
 
-        case Parser::token::OBJECT_IDENTIFIER: {
-            string id = token.value.as<string>();
-            cout << "," << id;
-            break;
+    private:
+        static const size_t capacity = 1 << 16;
+
+        /**
+         * @brief Length of a line without its payload: two integers, the
+         * longest token name and the separators.
+         */
+        static const size_t max_line_length = 64;
+
+        vector<char> buffer;
+        size_t size;
+
+        /**
+         * @brief Decoded string literal.
+         */
+        string scratch;
+
+        void append(char c) {
+            buffer[size++] = c;
         }
 
-        case Parser::token::STRING_LITERAL: {
-            string s = token.value.as<string>();
-            cout << ",\"" << s << "\"";
-            break;
+        void append(const char *s) {
+            append(s, strlen(s));
         }
 
-        default:
-            break;
+        void append(const char *s, size_t length) {
+            if (length > capacity - size) {
+                // Longer than the buffer, write it directly
+                flush();
+                cout.write(s, length);
+                return;
+            }
+
+            memcpy(buffer.data() + size, s, length);
+            size += length;
+        }
+
+        void append_int(int value) {
+            char digits[12];
+            char *end = digits + sizeof(digits);
+            char *begin = end;
+            unsigned int n = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+
+            do {
+                *--begin = '0' + n % 10;
+                n /= 10;
+            } while (n != 0);
+
+            if (value < 0)
+                *--begin = '-';
+
+            append(begin, end - begin);
+        }
+};
+
+/**
+ * @brief Read the tokens of a scanner up to the end of its range.
+ *
+ * @param scanner The scanner.
+ * @param tokens The store receiving the tokens.
+ * @param eof_location Receives the location of the end, if the scan ended
+ * outside of any comment and string literal.
+ * @param error Set to 1 on a lexical error.
+ *
+ * @return bool false if the scan ended in a comment or a string literal.
+ */
+static bool scan(Scanner &scanner, TokenStore &tokens, location &eof_location, int &error) {
+    while (true) {
+        Parser::symbol_type token = scanner.next();
+        Parser::token_type type = (Parser::token_type)token.type_get();
+
+        if (type == Parser::token::YYEOF) {
+            eof_location = token.location;
+            return true;
+        }
+
+        if (type != Parser::token::YYerror && type != Parser::token::EOFERROR)
+            tokens.push(type, scanner.token_offset, scanner.scan_offset - scanner.token_offset,
+                        token.location.begin);
+
+        else
+            error = 1;
+
+        if (type == Parser::token::EOFERROR)
+            return false;
+    }
+}
+
+/**
+ * @brief Find the beginning of a class declaration at the beginning of a
+ * line.
+ *
+ * @param source The source code.
+ * @param from The smallest offset of the class, at least 1.
+ *
+ * @return size_t The offset of the class keyword, or npos.
+ */
+static size_t find_class(const string &source, size_t from) {
+    for (size_t i = from - 1; (i = source.find("\nclass", i)) != string::npos; i++) {
+        size_t end = i + 6;
+        if (end == source.size() || !(isalnum((unsigned char) source[end]) || source[end] == '_'))
+            return i + 1;
+    }
+
+    return string::npos;
+}
+
+/**
+ * @brief A chunk of the source code, lexed as if it started outside of
+ * any comment and string literal.
+ *
+ * The lines of the tokens, of the errors and of the end are counted from
+ * the beginning of the chunk.
+ */
+struct Chunk {
+    size_t begin;
+    size_t end;
+    TokenStore tokens;
+    vector<LexicalError> errors;
+    location eof_location;
+    int error = 0;
+
+    /**
+     * @brief Whether the scan ended outside of any comment and string
+     * literal, the following chunk then starts in the right state.
+     */
+    bool clean = false;
+};
+
+static void lex_chunk(const string &source, string *filename, Chunk &chunk) {
+    Scanner scanner(source, chunk.begin, chunk.end, position(filename));
+
+    chunk.clean = scan(scanner, chunk.tokens, chunk.eof_location, chunk.error);
+    chunk.errors = std::move(scanner.errors);
+}
+
+int Driver::read_source() {
+    FILE *file;
+    if (source_file.empty() || source_file == "-")
+        file = stdin;
+    else if (!(file = fopen(source_file.c_str(), "r")))
+    {
+        *errors << "cannot open " << source_file << ": " << strerror(errno) << '\n';
+        return EXIT_FAILURE;
     }
 
-    cout << endl;
+    // Scan the whole source from memory, the tokens refer to it
+    string source;
+    char buffer[1 << 16];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        source.append(buffer, n);
+
+    if (file != stdin)
+        fclose(file);
+
+    tokens.set_source(std::move(source));
+
+    return 0;
 }
 
 int Driver::lex() {
-    scan_begin();
+    if (read_source() != 0)
+        return 1;
+
+    return lex_source();
+}
+
+int Driver::lex_source() {
+    tokens.clear();
+
+    const string &source = tokens.get_source();
+    size_t threads = max(thread::hardware_concurrency(), 1u);
+    size_t chunks = min(threads, source.size() / min_chunk_size);
+    if (chunks > 1)
+        return lex_chunks(chunks);
+
+    Scanner scanner(source, 0, source.size(), position(&source_file));
 
     int error = 0;
+    scan(scanner, tokens, eof_location, error);
 
-    while (true) {
-        Parser::symbol_type token = yylex();
+    Scanner::print_errors(scanner.errors, 0, *errors);
+
+    return error;
+}
+
+int Driver::lex_chunks(size_t count) {
+    const string &source = tokens.get_source();
 
-        if ((Parser::token_type)token.type_get() == Parser::token::YYEOF)
+    // Split the source before classes, into chunks of about the same size
+    vector<Chunk> chunks(1);
+    chunks[0].begin = 0;
+    for (size_t i = 1; i < count; i++) {
+        size_t split = find_class(source, max(source.size() / count * i, chunks.back().begin + 1));
+        if (split == string::npos)
             break;
 
-        if ((Parser::token_type)token.type_get() != Parser::token::YYerror
-            && (Parser::token_type)token.type_get() != Parser::token::EOFERROR)
-            tokens.push_back(token);
+        chunks.back().end = split;
+        chunks.emplace_back();
+        chunks.back().begin = split;
+    }
+    chunks.back().end = source.size();
+
+    vector<thread> workers;
+    for (size_t i = 1; i < chunks.size(); i++)
+        workers.emplace_back(lex_chunk, cref(source), &source_file, ref(chunks[i]));
+
+    lex_chunk(source, &source_file, chunks[0]);
+
+    for (thread &worker : workers)
+        worker.join();
+
+    // Keep the chunks starting in the right state, with their lines
+    // counted from the beginning of the source
+    int error = 0;
+    int lines = 0;
+    size_t i = 0;
+    while (i < chunks.size()) {
+        Chunk &chunk = chunks[i];
+
+        if (chunk.clean || i + 1 == chunks.size()) {
+            tokens.append(chunk.tokens, lines);
+            Scanner::print_errors(chunk.errors, lines, *errors);
+            error |= chunk.error;
+
+            if (chunk.clean) {
+                eof_location = chunk.eof_location;
+                eof_location.begin.line += lines;
+                eof_location.end.line += lines;
+                lines = eof_location.begin.line - 1;
+            }
+
+            i++;
+            continue;
+        }
+
+        // The chunk ends in a comment or a string literal. Lex from its
+        // beginning again, up to a token at the beginning of a following
+        // chunk: this chunk starts in the right state.
+        Scanner scanner(source, chunk.begin, source.size(), position(&source_file, lines + 1, 1));
+        size_t next = i + 1;
+
+        while (true) {
+            Parser::symbol_type token = scanner.next();
+            Parser::token_type type = (Parser::token_type)token.type_get();
+
+            if (type == Parser::token::YYEOF) {
+                eof_location = token.location;
+                next = chunks.size();
+                break;
+            }
+
+            if (type == Parser::token::EOFERROR) {
+                error = 1;
+                next = chunks.size();
+                break;
+            }
+
+            while (next < chunks.size() && chunks[next].begin < scanner.token_offset)
+                next++;
+
+            if (next < chunks.size() && chunks[next].begin == scanner.token_offset) {
+                lines = token.location.begin.line - 1;
+                break;
+            }
+
+            if (type == Parser::token::YYerror)
+                error = 1;
+            else
+                tokens.push(type, scanner.token_offset, scanner.scan_offset - scanner.token_offset,
+                            token.location.begin);
+        }
+
+        Scanner::print_errors(scanner.errors, 0, *errors);
+        i = next;
+    }
 
+    return error;
+}
+
+int Driver::edit(size_t offset, size_t removed, const string &text, TokenEdit &change) {
+    tokens.edit_source(offset, removed, text);
+
+    ptrdiff_t delta = (ptrdiff_t) text.size() - (ptrdiff_t) removed;
+    size_t edit_end = offset + text.size();
+
+    // Number of tokens ending before the edit
+    size_t before = 0, after = tokens.size();
+    while (before < after) {
+        size_t middle = before + (after - before) / 2;
+        if (tokens.offset(middle) + tokens.length(middle) < offset)
+            before = middle + 1;
         else
-            error = 1;
+            after = middle;
+    }
+
+    // A token ending before the edit can still be extended by the token
+    // following it, restart one token before.
+    size_t start = 0;
+    position start_position(&source_file);
+    if (before > 0) {
+        change.begin = before - 1;
+        start = tokens.offset(change.begin);
+        start_position = position(&source_file, tokens.line(change.begin), tokens.column(change.begin));
+    } else {
+        change.begin = 0;
+    }
+
+    Scanner scanner(tokens.get_source(), start, tokens.get_source().size(), start_position);
+
+    TokenStore fresh;
+    size_t old = change.begin;
+    bool synchronized = false;
+    int error = 0;
+
+    while (true) {
+        Parser::symbol_type token = scanner.next();
+        Parser::token_type type = (Parser::token_type)token.type_get();
 
-        if ((Parser::token_type)token.type_get() == Parser::token::EOFERROR) {
+        if (type == Parser::token::YYEOF) {
+            eof_location = token.location;
+            break;
+        }
+
+        if (type == Parser::token::YYerror || type == Parser::token::EOFERROR) {
             error = 1;
             break;
         }
 
+        size_t token_offset = scanner.token_offset;
+        size_t length = scanner.scan_offset - token_offset;
+
+        // Look for the token at the same place before the edit, if this
+        // place was not inserted by the edit
+        bool same = false;
+        if (token_offset < offset || token_offset >= edit_end) {
+            size_t old_offset = token_offset < offset ? token_offset : token_offset - delta;
+
+            while (old < tokens.size() && tokens.offset(old) < old_offset)
+                old++;
+
+            same = old < tokens.size() && tokens.offset(old) == old_offset
+                && tokens.kind(old) == type && tokens.length(old) == length;
+        }
+
+        if (same && token_offset + length < offset && fresh.size() == 0) {
+            // Unchanged token before the edit
+            change.begin = ++old;
+            continue;
+        }
+
+        if (same && token_offset >= edit_end) {
+            // Same token as before the edit, the following ones are unchanged
+            int lines = token.location.begin.line - tokens.line(old);
+            int columns = token.location.begin.column - tokens.column(old);
+
+            if (eof_location.begin.line == tokens.line(old)) {
+                eof_location.begin.column += columns;
+                eof_location.end.column += columns;
+            }
+            eof_location.begin.line += lines;
+            eof_location.end.line += lines;
+
+            tokens.shift(old, delta, lines, columns);
+            synchronized = true;
+            break;
+        }
+
+        fresh.push(type, token_offset, length, token.location.begin);
     }
 
-    scan_end();
+    Scanner::print_errors(scanner.errors, 0, *errors);
 
-    return error;
+    if (error)
+        return error;
+
+    change.old_end = synchronized ? old : tokens.size();
+    tokens.replace(change.begin, change.old_end, fresh);
+    change.new_end = change.begin + fresh.size();
+
+    return 0;
 }
 
 int Driver::parse() {
-    scan_begin();
+    return parse(0, tokens.size());
+}
 
-    parser = new Parser(*this);
+int Driver::parse(size_t begin, size_t end) {
+    next_token_index = begin;
+    end_token_index = end;
+    syntax_errors = 0;
+    res = nullptr;
+
+    if (parser_kind == ParserKind::FAST) {
+        try {
+            res = FastParser(*this).parse();
+        } catch (const SyntaxError &) {
+            return 1;
+        }
 
-    int res = parser->parse();
-    
-    scan_end();
+        return 0;
+    }
 
+    parser = new Parser(*this);
+
+    // The parser recovers from the syntax errors, to report them all
+    int failed = parser->parse();
     delete parser;
 
-    return res;
+    if (failed == 0 && syntax_errors == 0)
+        return 0;
+
+    // The AST of a program with errors has no node where they were
+    // reported, it is not given to the passes
+    if (res != nullptr) {
+        for (auto &classNode : res->getClasses())
+            delete classNode;
+        delete res;
+        res = nullptr;
+    }
+
+    return 1;
+}
+
+Parser::symbol_type Driver::next_token() {
+    if (next_token_index == end_token_index)
+        return Parser::make_YYEOF(end_location());
+
+    return tokens.symbol(next_token_index++, &source_file);
+}
+
+location Driver::end_location() {
+    if (end_token_index == tokens.size())
+        return eof_location;
+
+    // End of a range, at the beginning of the token following it
+    position begin(&source_file, tokens.line(end_token_index), tokens.column(end_token_index));
+    return location(begin, begin);
 }
 
 void Driver::print_tokens() {
-    for (auto token : tokens)
-        print_token(token);
+    TokenWriter writer;
+
+    for (size_t i = 0; i < tokens.size(); i++)
+        writer.write(tokens, i);
 }
\ No newline at end of file
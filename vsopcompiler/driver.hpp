@@ -1,18 +1,48 @@
 #ifndef _DRIVER_HPP
 #define _DRIVER_HPP
 
+#include <cstddef>
+#include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 #include <map>
 
 #include "parser.hpp"
 #include "ast.hpp"
-
-// Give prototype of yylex() function, then declare it.
-#define YY_DECL VSOP::Parser::symbol_type yylex()
-YY_DECL;
+#include "tokenStore.hpp"
 
 namespace VSOP {
+    /**
+     * @brief The tokens changed by an edit of the source: the tokens
+     * [begin, old_end) were replaced by the tokens [begin, new_end).
+     */
+    struct TokenEdit {
+        std::size_t begin;
+        std::size_t old_end;
+        std::size_t new_end;
+    };
+
+    /**
+     * @brief Thrown by the FastParser on its first syntax error.
+     */
+    struct SyntaxError {};
+
+    /**
+     * @brief The parsers of the tokens.
+     */
+    enum class ParserKind {
+        /**
+         * @brief The LALR parser generated by bison from parser.y.
+         */
+        BISON,
+
+        /**
+         * @brief The hand-written FastParser.
+         */
+        FAST
+    };
+
     class Driver {
         public:
             /**
@@ -20,7 +50,8 @@ namespace VSOP {
              *
              * @param _source_file The file containing the source code.
              */
-            Driver(const std::string &_source_file) : source_file(_source_file) {}
+            Driver(const std::string &_source_file)
+                : syntax_errors(0), res(nullptr), source_file(_source_file), parser_kind(ParserKind::BISON), errors(&std::cerr) {}
 
             /**
              * @brief Get the source file.
@@ -56,6 +87,18 @@ namespace VSOP {
              */
             int get_variable(std::string name) { return variables.at(name); }
 
+            /**
+             * @brief Set the source code, instead of reading the source file.
+             *
+             * @param source The source code.
+             */
+            void set_source(std::string source) { tokens.set_source(std::move(source)); }
+
+            /**
+             * @brief Get the source code.
+             */
+            const std::string &get_source() const { return tokens.get_source(); }
+
             /**
              * @brief Run the lexer on the source file.
              *
@@ -64,12 +107,78 @@ namespace VSOP {
             int lex();
 
             /**
-             * @brief Run the parser on the source file and compute the result.
+             * @brief Run the lexer on the source code already read or set.
+             *
+             * A large source is split in chunks lexed at the same time on
+             * several threads, see lex_chunks().
+             *
+             * @return int 0 if no lexical error.
+             */
+            int lex_source();
+
+            /**
+             * @brief Replace a range of the source code and run the lexer again
+             * on the tokens changed by the edit only.
+             *
+             * The lexer restarts at a token before the edit and stops at the
+             * first token after it found at the same place as before the edit,
+             * the following tokens are only moved.
+             *
+             * @param offset The offset of the range.
+             * @param removed The length of the range.
+             * @param text The text replacing the range.
+             * @param change Receives the tokens changed by the edit.
+             *
+             * @return int 0 if no lexical error. Otherwise, the tokens do not
+             * match the source anymore and lex_source() must be called.
+             */
+            int edit(std::size_t offset, std::size_t removed, const std::string &text,
+                     TokenEdit &change);
+
+            /**
+             * @brief Set the stream of the lexical and syntax errors.
+             *
+             * @param stream The stream, the standard error by default.
+             */
+            void set_errors(std::ostream &stream) { errors = &stream; }
+
+            /**
+             * @brief Get the stream of the lexical and syntax errors.
+             */
+            std::ostream &get_errors() const { return *errors; }
+
+            /**
+             * @brief Choose the parser run by parse().
+             *
+             * @param kind The parser, bison by default.
+             */
+            void set_parser(ParserKind kind) { parser_kind = kind; }
+
+            /**
+             * @brief Run the parser on the tokens read by lex() and compute the result.
              *
              * @return int 0 if no syntax error.
              */
             int parse();
 
+            /**
+             * @brief Run the parser on a range of the tokens, as if they were
+             * the whole program, and compute the result.
+             *
+             * @param begin The index of the first token.
+             * @param end The index following the last token.
+             *
+             * @return int 0 if no syntax error.
+             */
+            int parse(std::size_t begin, std::size_t end);
+
+            /**
+             * @brief Get the next token for the parser.
+             *
+             * @return Parser::symbol_type The token, or the end of file.
+             */
+            Parser::symbol_type next_token();
+
             /**
              * @brief Run the semantic checker on the source file and compute the result.
              *
@@ -82,20 +191,53 @@ namespace VSOP {
              */
             void print_tokens();
 
+            /**
+             * @brief Get the number of tokens read by lex().
+             *
+             * @return std::size_t The number of tokens.
+             */
+            std::size_t get_token_count() const { return tokens.size(); }
+
+            /**
+             * @brief Get the tokens read by lex().
+             */
+            const TokenStore &get_tokens() const { return tokens; }
+
             /**
              * @brief The result of the computation.
              */
             int result;
 
+            /**
+             * @brief The number of syntax errors reported by the last parse.
+             */
+            int syntax_errors;
 
+            /**
+             * @brief The AST built by the last parse, nullptr if it reported
+             * a syntax error: bison recovers from the errors but gives no
+             * node where it reported them.
+             */
             AST::ProgramNode* res;
 
         private:
+            friend class FastParser;
+
             /**
              * @brief The source file.
              */
             std::string source_file;
 
+            /**
+             * @brief The parser run by parse().
+             */
+            ParserKind parser_kind;
+
+            /**
+             * @brief The stream of the lexical and syntax errors.
+             */
+            std::ostream *errors;
+
             /**
              * @brief The parser.
              */
@@ -109,17 +251,52 @@ namespace VSOP {
             /**
              * @brief Store the tokens.
              */
-            std::vector<Parser::symbol_type> tokens;
+            TokenStore tokens;
+
+            /**
+             * @brief The location of the end of file.
+             */
+            location eof_location;
+
+            /**
+             * @brief The index of the next token given to the parser.
+             */
+            std::size_t next_token_index;
+
+            /**
+             * @brief The index following the last token given to the parser.
+             */
+            std::size_t end_token_index;
+
+            /**
+             * @brief Get the location of the end of the tokens given to the
+             * parser.
+             */
+            location end_location();
 
             /**
-             * @brief Start the lexer.
+             * @brief Read the source file.
+             *
+             * @return int 0 if the file could be read.
              */
-            void scan_begin();
+            int read_source();
 
             /**
-             * @brief Stop the lexer.
+             * @brief Run the lexer on chunks of the source starting with a
+             * class, each on its own thread.
+             *
+             * A chunk is lexed as if it started outside of any comment and
+             * string literal. If the chunk before it ends in a comment or
+             * a string literal, the source is lexed again from the
+             * beginning of this chunk, up to a chunk starting in the right
+             * state. The tokens and the errors are the same as lexing the
+             * whole source at once.
+             *
+             * @param count The maximum number of chunks.
+             *
+             * @return int 0 if no lexical error.
              */
-            void scan_end();
+            int lex_chunks(std::size_t count);
     };
 }
 
@@ -0,0 +1,562 @@
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "fastParser.hpp"
+#include "driver.hpp"
+
+using namespace std;
+using namespace VSOP;
+
+/**
+ * @brief The precedence levels of parser.y, from the lowest.
+ *
+ * The "if", "while" and "let" expressions extend as far as possible,
+ * below all the levels.
+ */
+enum Level {
+    LOWEST,
+    ASSIGN_LEVEL,       // "<-", right
+    AND_LEVEL,          // "and", left
+    NOT_LEVEL,          // "not", right
+    COMPARISON_LEVEL,   // "<" "<=" "=", nonassoc
+    SUM_LEVEL,          // "+" "-", left
+    PRODUCT_LEVEL,      // "*" "/", left
+    UNARY_LEVEL,        // unary "-" "isnull", right
+    POW_LEVEL,          // "^", right
+    DOT_LEVEL           // ".", left
+};
+
+/**
+ * @brief The levels of the binary operators, indexed by token kind, LOWEST
+ * for the other tokens.
+ */
+struct BinaryLevels {
+    unsigned char levels[Parser::symbol_kind::YYNTOKENS];
+};
+
+static constexpr BinaryLevels make_binary_levels() {
+    BinaryLevels table = {};
+
+    table.levels[Parser::token::AND] = AND_LEVEL;
+    table.levels[Parser::token::EQUAL] = COMPARISON_LEVEL;
+    table.levels[Parser::token::LOWER] = COMPARISON_LEVEL;
+    table.levels[Parser::token::LOWER_EQUAL] = COMPARISON_LEVEL;
+    table.levels[Parser::token::PLUS] = SUM_LEVEL;
+    table.levels[Parser::token::MINUS] = SUM_LEVEL;
+    table.levels[Parser::token::TIMES] = PRODUCT_LEVEL;
+    table.levels[Parser::token::DIV] = PRODUCT_LEVEL;
+    table.levels[Parser::token::POW] = POW_LEVEL;
+    table.levels[Parser::token::DOT] = DOT_LEVEL;
+
+    return table;
+}
+
+static constexpr BinaryLevels binary_levels = make_binary_levels();
+
+static const char *const expected_object_identifier =
+    "expected an object-identifier but type-identifier was given";
+static const char *const expected_type_identifier =
+    "expected a type-identifier but object-identifier was given";
+
+/**
+ * @brief The nodes of a list not given to its node yet, deleted if a syntax
+ * error is thrown before.
+ */
+template <typename T>
+class NodeList {
+    public:
+        NodeList() = default;
+        NodeList(const NodeList &) = delete;
+        NodeList &operator=(const NodeList &) = delete;
+
+        ~NodeList() {
+            for (T *node : nodes)
+                delete node;
+        }
+
+        void push_back(T *node) { nodes.push_back(node); }
+
+        /**
+         * @brief Give the nodes to their node, which takes them from the
+         * last one.
+         */
+        vector<T*> take() {
+            vector<T*> taken(nodes.rbegin(), nodes.rend());
+            nodes.clear();
+            return taken;
+        }
+
+    private:
+        vector<T*> nodes;
+};
+
+FastParser::FastParser(Driver &driver)
+    : driver(driver), next(driver.next_token_index), end(driver.end_token_index) {}
+
+Parser::token_type FastParser::peek() const {
+    if (next == end)
+        return Parser::token::YYEOF;
+
+    return driver.tokens.kind(next);
+}
+
+bool FastParser::accept(Parser::token_type kind) {
+    if (peek() != kind)
+        return false;
+
+    next++;
+    return true;
+}
+
+void FastParser::expect(Parser::token_type kind) {
+    if (!accept(kind))
+        syntax_error();
+}
+
+string FastParser::lexeme(size_t i) const {
+    return string(driver.tokens.lexeme(i), driver.tokens.length(i));
+}
+
+int FastParser::line(size_t i) const {
+    return driver.tokens.line(i);
+}
+
+int FastParser::column(size_t i) const {
+    return driver.tokens.column(i);
+}
+
+void FastParser::error(size_t i, const string &m) {
+    location loc = driver.end_location();
+    if (i != end) {
+        position begin(&driver.source_file, line(i), column(i));
+        loc = location(begin, begin);
+    }
+
+    Parser(driver).error(loc, m);
+
+    // Stop at the first error, without recovery
+    throw SyntaxError();
+}
+
+AST::ProgramNode *FastParser::parse() {
+    size_t first = next;
+    NodeList<AST::ClassNode> classes;
+
+    do
+        classes.push_back(parse_class());
+    while (peek() == Parser::token::CLASS);
+
+    if (peek() != Parser::token::YYEOF)
+        syntax_error();
+
+    return new AST::ProgramNode(classes.take(), driver.source_file, line(first), column(first));
+}
+
+AST::ClassNode *FastParser::parse_class() {
+    size_t first = next;
+    expect(Parser::token::CLASS);
+
+    size_t name = next;
+    expect(Parser::token::TYPE_IDENTIFIER);
+
+    string parent;
+    if (accept(Parser::token::EXTENDS)) {
+        size_t parent_name = next;
+        expect(Parser::token::TYPE_IDENTIFIER);
+        parent = lexeme(parent_name);
+    }
+
+    AST::ClassBodyNode *body = parse_class_body();
+
+    string str = lexeme(name);
+    return new AST::ClassNode(&str, &parent, body, driver.source_file, line(first), column(first));
+}
+
+AST::ClassBodyNode *FastParser::parse_class_body() {
+    NodeList<AST::FieldNode> fields;
+    NodeList<AST::MethodNode> methods;
+
+    expect(Parser::token::LBRACE);
+
+    while (!accept(Parser::token::RBRACE)) {
+        size_t name = next;
+        if (!accept(Parser::token::OBJECT_IDENTIFIER) && !accept(Parser::token::TYPE_IDENTIFIER))
+            syntax_error();
+
+        if (accept(Parser::token::COLON)) {
+            unique_ptr<AST::TypeNode> type(parse_type());
+
+            unique_ptr<AST::ExprNode> init;
+            if (accept(Parser::token::ASSIGN))
+                init.reset(parse_expr(LOWEST));
+            expect(Parser::token::SEMICOLON);
+
+            if (driver.tokens.kind(name) == Parser::token::TYPE_IDENTIFIER)
+                error(name, expected_object_identifier);
+
+            string str = lexeme(name);
+            fields.push_back(new AST::FieldNode(&str, type.release(), init.release(), driver.source_file, line(name), column(name)));
+        } else if (accept(Parser::token::LPAR)) {
+            unique_ptr<AST::FormalsNode> formals(parse_formals());
+            expect(Parser::token::RPAR);
+            expect(Parser::token::COLON);
+            unique_ptr<AST::TypeNode> type(parse_type());
+            unique_ptr<AST::BlockNode> block(parse_block());
+
+            if (driver.tokens.kind(name) == Parser::token::TYPE_IDENTIFIER)
+                error(name, expected_object_identifier);
+
+            string str = lexeme(name);
+            methods.push_back(new AST::MethodNode(&str, formals.release(), type.release(), block.release(), driver.source_file, line(name), column(name)));
+        } else
+            syntax_error();
+    }
+
+    return new AST::ClassBodyNode(fields.take(), methods.take());
+}
+
+AST::TypeNode *FastParser::parse_type() {
+    size_t first = next;
+    string str;
+
+    switch (peek()) {
+        case Parser::token::TYPE_IDENTIFIER:
+            str = lexeme(first);
+            break;
+
+        case Parser::token::INT32:
+            str = "int32";
+            break;
+
+        case Parser::token::BOOL:
+            str = "bool";
+            break;
+
+        case Parser::token::STRING:
+            str = "string";
+            break;
+
+        case Parser::token::UNIT:
+            str = "unit";
+            break;
+
+        case Parser::token::OBJECT_IDENTIFIER:
+            error(first, expected_type_identifier);
+
+        default:
+            syntax_error();
+    }
+
+    next++;
+    return new AST::TypeNode(&str, driver.source_file, line(first), column(first));
+}
+
+AST::FormalsNode *FastParser::parse_formals() {
+    NodeList<AST::FormalNode> formals;
+
+    if (peek() != Parser::token::RPAR) {
+        do {
+            size_t name = next;
+            expect(Parser::token::OBJECT_IDENTIFIER);
+            expect(Parser::token::COLON);
+            AST::TypeNode *type = parse_type();
+
+            string str = lexeme(name);
+            formals.push_back(new AST::FormalNode(&str, type));
+        } while (accept(Parser::token::COMMA));
+    }
+
+    return new AST::FormalsNode(formals.take());
+}
+
+AST::BlockNode *FastParser::parse_block() {
+    NodeList<AST::ExprNode> exprs;
+
+    expect(Parser::token::LBRACE);
+
+    do
+        exprs.push_back(parse_expr(LOWEST));
+    while (accept(Parser::token::SEMICOLON));
+
+    expect(Parser::token::RBRACE);
+
+    return new AST::BlockNode(exprs.take());
+}
+
+AST::ArgsNode *FastParser::parse_args() {
+    NodeList<AST::ExprNode> exprs;
+
+    expect(Parser::token::LPAR);
+
+    if (peek() != Parser::token::RPAR) {
+        do
+            exprs.push_back(parse_expr(LOWEST));
+        while (accept(Parser::token::COMMA));
+    }
+
+    expect(Parser::token::RPAR);
+
+    return new AST::ArgsNode(exprs.take());
+}
+
+AST::ExprNode *FastParser::parse_expr(int level) {
+    size_t first = next;
+    const string &filename = driver.source_file;
+
+    unique_ptr<AST::ExprNode> left(parse_prefix());
+    int previous = LOWEST;
+
+    while (true) {
+        Parser::token_type op = peek();
+        int op_level = binary_levels.levels[op];
+
+        // The operand on the left of the expression gets the operators of
+        // lower precedence, and of the same precedence unless they are
+        // right-associative
+        if (op_level == LOWEST || op_level < level || (op_level == level && op != Parser::token::POW))
+            return left.release();
+
+        // "<", "<=" and "=" are not associative
+        if (op_level == COMPARISON_LEVEL && previous == COMPARISON_LEVEL)
+            syntax_error();
+        previous = op_level;
+
+        size_t op_token = next++;
+
+        if (op == Parser::token::DOT) {
+            size_t name = next;
+            if (!accept(Parser::token::OBJECT_IDENTIFIER) && !accept(Parser::token::TYPE_IDENTIFIER))
+                syntax_error();
+
+            unique_ptr<AST::ArgsNode> args(parse_args());
+
+            if (driver.tokens.kind(name) == Parser::token::TYPE_IDENTIFIER)
+                error(name, expected_object_identifier);
+
+            string str = lexeme(name);
+            left.reset(new AST::CallExprNode(left.release(), &str, args.release(), filename, line(first), column(first)));
+            continue;
+        }
+
+        unique_ptr<AST::ExprNode> right(parse_expr(op_level));
+        int l = line(first), c = column(first);
+
+        switch (op) {
+            case Parser::token::AND:
+                left.reset(new AST::AndNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::EQUAL:
+                left.reset(new AST::EqualNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::LOWER:
+                left.reset(new AST::LowerNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::LOWER_EQUAL:
+                left.reset(new AST::LowerEqualNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::PLUS:
+                left.reset(new AST::PlusNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::MINUS:
+                left.reset(new AST::MinusNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::TIMES:
+                left.reset(new AST::TimesNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::DIV:
+                left.reset(new AST::DivNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            case Parser::token::POW:
+                left.reset(new AST::PowNode(left.release(), right.release(), filename, l, c));
+                break;
+
+            default:
+                error(op_token, "syntax error");
+        }
+    }
+}
+
+AST::ExprNode *FastParser::parse_prefix() {
+    // The end of the tokens does not start an expression
+    if (next == end)
+        syntax_error();
+
+    size_t first = next;
+    const string &filename = driver.source_file;
+    int l = line(first), c = column(first);
+
+    switch (peek()) {
+        case Parser::token::IF: {
+            next++;
+            unique_ptr<AST::ExprNode> cond(parse_expr(LOWEST));
+            expect(Parser::token::THEN);
+            unique_ptr<AST::ExprNode> then_expr(parse_expr(LOWEST));
+
+            // An "else" belongs to the closest "if"
+            AST::ExprNode *else_expr = nullptr;
+            if (accept(Parser::token::ELSE))
+                else_expr = parse_expr(LOWEST);
+
+            return new AST::IfThenElseExprNode(cond.release(), then_expr.release(), else_expr, filename, l, c);
+        }
+
+        case Parser::token::WHILE: {
+            next++;
+            unique_ptr<AST::ExprNode> cond(parse_expr(LOWEST));
+
+            size_t semicolon = next;
+            bool misplaced = accept(Parser::token::SEMICOLON);
+
+            expect(Parser::token::DO);
+            unique_ptr<AST::ExprNode> body(parse_expr(LOWEST));
+
+            if (misplaced)
+                error(semicolon, "unexpected semicolon");
+
+            return new AST::WhileDoExprNode(cond.release(), body.release(), filename, l, c);
+        }
+
+        case Parser::token::LET: {
+            next++;
+            size_t name = next;
+            if (!accept(Parser::token::OBJECT_IDENTIFIER) && !accept(Parser::token::TYPE_IDENTIFIER))
+                syntax_error();
+
+            expect(Parser::token::COLON);
+            unique_ptr<AST::TypeNode> type(parse_type());
+
+            unique_ptr<AST::ExprNode> init;
+            if (accept(Parser::token::ASSIGN))
+                init.reset(parse_expr(LOWEST));
+
+            expect(Parser::token::IN);
+            unique_ptr<AST::ExprNode> scope(parse_expr(LOWEST));
+
+            if (driver.tokens.kind(name) == Parser::token::TYPE_IDENTIFIER)
+                error(name, expected_object_identifier);
+
+            string str = lexeme(name);
+            return new AST::LetExprNode(&str, type.release(), init.release(), scope.release(), filename, l, c);
+        }
+
+        case Parser::token::OBJECT_IDENTIFIER: {
+            next++;
+            string str = lexeme(first);
+
+            if (accept(Parser::token::ASSIGN)) {
+                AST::ExprNode *value = parse_expr(ASSIGN_LEVEL);
+
+                // The nodes move the strings they are given
+                string variable_name = str;
+                AST::VariableExprNode *variable = new AST::VariableExprNode(&variable_name, filename, l, c);
+                return new AST::AssignExprNode(&str, variable, value, filename, l, c);
+            }
+
+            if (peek() == Parser::token::LPAR) {
+                AST::ArgsNode *args = parse_args();
+                string self = "self";
+                AST::ExprNode *object = new AST::VariableExprNode(&self, filename, l, c);
+                return new AST::CallExprNode(object, &str, args, filename, l, c);
+            }
+
+            return new AST::VariableExprNode(&str, filename, l, c);
+        }
+
+        case Parser::token::TYPE_IDENTIFIER:
+            next++;
+
+            // Parsed for their syntax errors only
+            if (accept(Parser::token::ASSIGN))
+                delete parse_expr(ASSIGN_LEVEL);
+            else if (peek() == Parser::token::LPAR)
+                delete parse_args();
+
+            error(first, expected_object_identifier);
+
+        case Parser::token::NOT: {
+            next++;
+            AST::ExprNode *expr = parse_expr(NOT_LEVEL);
+            return new AST::NotNode(expr, filename, l, c);
+        }
+
+        case Parser::token::MINUS: {
+            next++;
+            AST::ExprNode *expr = parse_expr(UNARY_LEVEL);
+            return new AST::UnaryMinusNode(expr, filename, l, c);
+        }
+
+        case Parser::token::ISNULL: {
+            next++;
+            AST::ExprNode *expr = parse_expr(UNARY_LEVEL);
+            return new AST::IsNullNode(expr, filename, l, c);
+        }
+
+        case Parser::token::NEW: {
+            next++;
+            size_t name = next;
+            if (accept(Parser::token::OBJECT_IDENTIFIER))
+                error(name, expected_type_identifier);
+            expect(Parser::token::TYPE_IDENTIFIER);
+
+            string str = lexeme(name);
+            return new AST::NewExprNode(&str, filename, l, c);
+        }
+
+        case Parser::token::SELF: {
+            next++;
+            string str = "self";
+            return new AST::VariableExprNode(&str, filename, l, c);
+        }
+
+        case Parser::token::INTEGER_LITERAL: {
+            next++;
+            string str = to_string(driver.tokens.integer(first));
+            return new AST::IntegerLiteralNode(&str, filename, l, c);
+        }
+
+        case Parser::token::STRING_LITERAL: {
+            next++;
+            string str;
+            driver.tokens.string_literal(first, str);
+            str.insert(str.begin(), '"');
+            str += '"';
+            return new AST::LiteralNode(&str, filename, l, c);
+        }
+
+        case Parser::token::TRUE:
+            next++;
+            return new AST::BooleanLiteralNode(true, filename, l, c);
+
+        case Parser::token::FALSE:
+            next++;
+            return new AST::BooleanLiteralNode(false, filename, l, c);
+
+        case Parser::token::LPAR: {
+            next++;
+            if (accept(Parser::token::RPAR))
+                return new AST::UnitExprNode(filename, l, c);
+
+            unique_ptr<AST::ExprNode> expr(parse_expr(LOWEST));
+            expect(Parser::token::RPAR);
+            return new AST::ParExprNode(expr.release(), filename, l, c);
+        }
+
+        case Parser::token::LBRACE: {
+            AST::BlockNode *block = parse_block();
+            return new AST::BlockExprNode(block, filename, l, c);
+        }
+
+        default:
+            syntax_error();
+    }
+}
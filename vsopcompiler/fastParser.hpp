@@ -0,0 +1,112 @@
+#ifndef _FAST_PARSER_HPP
+#define _FAST_PARSER_HPP
+
+#include <cstddef>
+#include <string>
+
+#include "ast.hpp"
+#include "parser.hpp"
+
+namespace VSOP {
+    class Driver;
+
+    /**
+     * @brief Hand-written parser of the tokens of a Driver, building the
+     * same AST as the bison parser.
+     *
+     * The classes and their members are parsed by recursive descent, the
+     * expressions by precedence climbing on the precedence table of
+     * parser.y. The nodes are built from the lexemes in the token store,
+     * without the semantic values of bison.
+     *
+     * The parse stops at the first syntax error, reported by
+     * Parser::error() at the same token and with the same message as the
+     * first error of the bison parser, which recovers from it.
+     */
+    class FastParser {
+        public:
+            /**
+             * @brief Construct a new FastParser on the range of tokens given
+             * to the parser by the driver.
+             *
+             * @param driver The driver.
+             */
+            FastParser(Driver &driver);
+
+            /**
+             * @brief Parse the tokens.
+             *
+             * @return AST::ProgramNode* The program.
+             */
+            AST::ProgramNode *parse();
+
+        private:
+            Driver &driver;
+
+            /**
+             * @brief The index of the next token.
+             */
+            std::size_t next;
+
+            /**
+             * @brief The index following the last token.
+             */
+            std::size_t end;
+
+            /**
+             * @brief Get the kind of the next token, YYEOF at the end.
+             */
+            Parser::token_type peek() const;
+
+            /**
+             * @brief Skip the next token if it is of a kind.
+             *
+             * @return bool true if it was skipped.
+             */
+            bool accept(Parser::token_type kind);
+
+            /**
+             * @brief Skip the next token, which must be of a kind.
+             */
+            void expect(Parser::token_type kind);
+
+            /**
+             * @brief Get the lexeme of a token.
+             */
+            std::string lexeme(std::size_t i) const;
+
+            int line(std::size_t i) const;
+            int column(std::size_t i) const;
+
+            /**
+             * @brief Report an error at a token, or at the end.
+             */
+            [[noreturn]] void error(std::size_t i, const std::string &m);
+
+            [[noreturn]] void syntax_error() { error(next, "syntax error"); }
+
+            AST::ClassNode *parse_class();
+            AST::ClassBodyNode *parse_class_body();
+            AST::TypeNode *parse_type();
+            AST::FormalsNode *parse_formals();
+            AST::BlockNode *parse_block();
+            AST::ArgsNode *parse_args();
+
+            /**
+             * @brief Parse an expression, as long as its binary operators
+             * have a precedence of at least level.
+             *
+             * @param level The precedence level of the operator on the left
+             * of the expression.
+             */
+            AST::ExprNode *parse_expr(int level);
+
+            /**
+             * @brief Parse an expression starting with a prefix operator or
+             * a keyword, or a primary expression.
+             */
+            AST::ExprNode *parse_prefix();
+    };
+}
+
+#endif
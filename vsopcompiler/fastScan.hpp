@@ -0,0 +1,95 @@
+#ifndef _FAST_SCAN_HPP
+#define _FAST_SCAN_HPP
+
+#include <cstddef>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace VSOP {
+    /**
+     * Scanning of the runs of ordinary characters in comments and string
+     * literals, 16 bytes at a time with SSE2 when available.
+     *
+     * A run ends at the first character that one of the lexer rules must
+     * see. The null character ends every run, so the end of the flex
+     * buffer is never crossed.
+     */
+    namespace fastScan {
+        // Characters with their own rule in a multi-line comment.
+        inline bool is_comment_special(char c) {
+            switch (c) {
+                case '(': case '*': case '\n': case '\t': case '\f': case '\r': case '\0':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // Characters with their own rule in a string literal.
+        inline bool is_string_special(char c) {
+            return c == '"' || c == '\\' || c == '\n' || c == '\0';
+        }
+
+#ifdef __SSE2__
+        // Mask of the bytes of v equal to c.
+        inline int match(__m128i v, char c) {
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+        }
+#endif
+
+        /**
+         * @brief Get the length of the run of ordinary comment characters.
+         *
+         * @param begin The first character of the run.
+         * @param end The end of the buffer.
+         */
+        inline std::size_t comment_run(const char *begin, const char *end) {
+            const char *p = begin;
+
+#ifdef __SSE2__
+            for (; end - p >= 16; p += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                int mask = match(v, '(') | match(v, '*') | match(v, '\n') | match(v, '\t')
+                         | match(v, '\f') | match(v, '\r') | match(v, '\0');
+
+                if (mask != 0)
+                    return p - begin + __builtin_ctz(mask);
+            }
+#endif
+
+            while (p < end && !is_comment_special(*p))
+                ++p;
+
+            return p - begin;
+        }
+
+        /**
+         * @brief Get the length of the run of ordinary string literal characters.
+         *
+         * @param begin The first character of the run.
+         * @param end The end of the buffer.
+         */
+        inline std::size_t string_run(const char *begin, const char *end) {
+            const char *p = begin;
+
+#ifdef __SSE2__
+            for (; end - p >= 16; p += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                int mask = match(v, '"') | match(v, '\\') | match(v, '\n') | match(v, '\0');
+
+                if (mask != 0)
+                    return p - begin + __builtin_ctz(mask);
+            }
+#endif
+
+            while (p < end && !is_string_special(*p))
+                ++p;
+
+            return p - begin;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,464 @@
+#include <cstdint>
+#include <vector>
+
+#include "fifthPass.hpp"
+
+/*
+    Fifth pass, over the type-checked AST, folding constant expressions, simplifying algebraic identities
+    and pruning dead branches before code generation. Division by zero and INT32_MIN / -1 are left to the runtime.
+*/
+
+// ProgramNode --> ClassNode
+void FifthPass::visit(AST::ProgramNode* node) {
+    for (auto& classNode : node->getClasses()) {
+        classNode->accept(this);
+    }
+}
+
+// ClassNode --> ClassBodyNode
+void FifthPass::visit(AST::ClassNode* node) {
+    AST::ClassBodyNode* classBodyNode = node->getClassBody();
+    if (classBodyNode != NULL) {
+        classBodyNode->accept(this);
+    }
+}
+
+// ClassBodyNode --> FieldNode and MethodNode
+void FifthPass::visit(AST::ClassBodyNode* node) {
+    for (auto& fieldNode : node->getFields()) {
+        fieldNode->accept(this);
+    }
+
+    for (auto& methodNode : node->getMethods()) {
+        methodNode->accept(this);
+    }
+}
+
+// FieldNode --> ExprNode
+void FifthPass::visit(AST::FieldNode* node) {
+    if (node->getInitExpr() != NULL) {
+        node->setInitExpr(fold(node->getInitExpr()));
+    }
+}
+
+// MethodNode --> BlockNode
+void FifthPass::visit(AST::MethodNode* node) {
+    AST::BlockNode* blockNode = node->getBlock();
+    if (blockNode != NULL) {
+        blockNode->accept(this);
+    }
+}
+
+// BlockNode --> ExprNode, and drop the side-effect free expressions whose value is discarded
+void FifthPass::visit(AST::BlockNode* node) {
+    std::vector<AST::ExprNode*>& exprNodes = node->getExpr();
+    std::vector<AST::ExprNode*> kept;
+
+    for (size_t i = 0; i < exprNodes.size(); ++i) {
+        AST::ExprNode* exprNode = fold(exprNodes[i]);
+
+        if (i + 1 < exprNodes.size() && isPure(exprNode)) {
+            delete exprNode;
+        } else {
+            kept.push_back(exprNode);
+        }
+    }
+
+    exprNodes = kept;
+}
+
+// IfThenElseExprNode --> ExprNode, and keep only the taken branch of a constant condition
+void FifthPass::visit(AST::IfThenElseExprNode* node) {
+    node->setCondExpr(fold(node->getCondExpr()));
+    node->setThenExpr(fold(node->getThenExpr()));
+    if (node->getElseExpr() != NULL) {
+        node->setElseExpr(fold(node->getElseExpr()));
+    }
+
+    bool cond;
+    if (!getBoolean(node->getCondExpr(), cond)) {
+        return;
+    }
+
+    AST::ExprNode* taken = cond ? node->getThenExpr() : node->getElseExpr();
+
+    if (taken == NULL) {
+        // if false then <expr> is just ()
+        result_ = makeUnit(node);
+        delete node;
+        return;
+    }
+
+    if (taken->getTypeId() == node->getTypeId()) {
+        result_ = taken;
+    } else if (node->getType() == AST::Type::UNIT) {
+        // The value of the branch is discarded
+        result_ = makeUnitBlock(taken, node);
+    } else {
+        // The branch has a more specific class than the conditional, keep it as is
+        return;
+    }
+
+    if (cond) {
+        node->setThenExpr(NULL);
+    } else {
+        node->setElseExpr(NULL);
+    }
+    delete node;
+}
+
+// WhileDoExprNode --> ExprNode, and drop loops that never run
+void FifthPass::visit(AST::WhileDoExprNode* node) {
+    node->setCondExpr(fold(node->getCondExpr()));
+    node->setBodyExpr(fold(node->getBodyExpr()));
+
+    bool cond;
+    if (getBoolean(node->getCondExpr(), cond) && !cond) {
+        result_ = makeUnit(node);
+        delete node;
+    }
+}
+
+// LetExprNode --> ExprNode
+void FifthPass::visit(AST::LetExprNode* node) {
+    if (node->getInitExpr() != NULL) {
+        node->setInitExpr(fold(node->getInitExpr()));
+    }
+    node->setScopeExpr(fold(node->getScopeExpr()));
+}
+
+// AssignExprNode --> ExprNode
+void FifthPass::visit(AST::AssignExprNode* node) {
+    node->setExpr(fold(node->getExpr()));
+}
+
+// AndNode --> ExprNode
+void FifthPass::visit(AST::AndNode* node) {
+    foldOperands(node);
+
+    bool left, right;
+    if (getBoolean(node->getLeftExpr(), left)) {
+        // false and <expr> never evaluates <expr>, true and <expr> is <expr>
+        result_ = left ? replace(node, node->getRightExpr()) : replace(node, makeBoolean(false, node));
+    } else if (getBoolean(node->getRightExpr(), right)) {
+        if (right) {
+            result_ = replace(node, node->getLeftExpr());
+        } else if (isPure(node->getLeftExpr())) {
+            result_ = replace(node, makeBoolean(false, node));
+        }
+    }
+}
+
+// EqualNode --> ExprNode
+void FifthPass::visit(AST::EqualNode* node) {
+    foldOperands(node);
+
+    int32_t leftInt, rightInt;
+    bool leftBool, rightBool;
+    if (getInteger(node->getLeftExpr(), leftInt) && getInteger(node->getRightExpr(), rightInt)) {
+        result_ = replace(node, makeBoolean(leftInt == rightInt, node));
+    } else if (getBoolean(node->getLeftExpr(), leftBool) && getBoolean(node->getRightExpr(), rightBool)) {
+        result_ = replace(node, makeBoolean(leftBool == rightBool, node));
+    }
+}
+
+// LowerNode --> ExprNode
+void FifthPass::visit(AST::LowerNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    if (getInteger(node->getLeftExpr(), left) && getInteger(node->getRightExpr(), right)) {
+        result_ = replace(node, makeBoolean(left < right, node));
+    }
+}
+
+// LowerEqualNode --> ExprNode
+void FifthPass::visit(AST::LowerEqualNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    if (getInteger(node->getLeftExpr(), left) && getInteger(node->getRightExpr(), right)) {
+        result_ = replace(node, makeBoolean(left <= right, node));
+    }
+}
+
+// PlusNode --> ExprNode
+void FifthPass::visit(AST::PlusNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    bool hasLeft = getInteger(node->getLeftExpr(), left);
+    bool hasRight = getInteger(node->getRightExpr(), right);
+
+    if (hasLeft && hasRight) {
+        result_ = replace(node, makeInteger((int32_t) ((uint32_t) left + (uint32_t) right), node));
+    } else if (hasLeft && left == 0) {
+        result_ = replace(node, node->getRightExpr());
+    } else if (hasRight && right == 0) {
+        result_ = replace(node, node->getLeftExpr());
+    }
+}
+
+// MinusNode --> ExprNode
+void FifthPass::visit(AST::MinusNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    bool hasLeft = getInteger(node->getLeftExpr(), left);
+    bool hasRight = getInteger(node->getRightExpr(), right);
+
+    if (hasLeft && hasRight) {
+        result_ = replace(node, makeInteger((int32_t) ((uint32_t) left - (uint32_t) right), node));
+    } else if (hasRight && right == 0) {
+        result_ = replace(node, node->getLeftExpr());
+    }
+}
+
+// TimesNode --> ExprNode
+void FifthPass::visit(AST::TimesNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    bool hasLeft = getInteger(node->getLeftExpr(), left);
+    bool hasRight = getInteger(node->getRightExpr(), right);
+
+    if (hasLeft && hasRight) {
+        result_ = replace(node, makeInteger((int32_t) ((uint32_t) left * (uint32_t) right), node));
+    } else if (hasLeft && left == 1) {
+        result_ = replace(node, node->getRightExpr());
+    } else if (hasRight && right == 1) {
+        result_ = replace(node, node->getLeftExpr());
+    } else if ((hasLeft && left == 0 && isPure(node->getRightExpr()))
+        || (hasRight && right == 0 && isPure(node->getLeftExpr()))) {
+        result_ = replace(node, makeInteger(0, node));
+    }
+}
+
+// DivNode --> ExprNode
+void FifthPass::visit(AST::DivNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    bool hasLeft = getInteger(node->getLeftExpr(), left);
+    bool hasRight = getInteger(node->getRightExpr(), right);
+
+    if (hasLeft && hasRight && right != 0 && !(left == INT32_MIN && right == -1)) {
+        result_ = replace(node, makeInteger(left / right, node));
+    } else if (hasRight && right == 1) {
+        result_ = replace(node, node->getLeftExpr());
+    }
+}
+
+// PowNode --> ExprNode
+void FifthPass::visit(AST::PowNode* node) {
+    foldOperands(node);
+
+    int32_t left, right;
+    bool hasLeft = getInteger(node->getLeftExpr(), left);
+    bool hasRight = getInteger(node->getRightExpr(), right);
+
+    if (hasLeft && hasRight) {
+        result_ = replace(node, makeInteger(power(left, right), node));
+    } else if (hasRight && right == 1) {
+        result_ = replace(node, node->getLeftExpr());
+    } else if ((hasRight && right == 0 && isPure(node->getLeftExpr()))
+        || (hasLeft && left == 1 && isPure(node->getRightExpr()))) {
+        result_ = replace(node, makeInteger(1, node));
+    }
+}
+
+// UnaryMinusNode --> ExprNode
+void FifthPass::visit(AST::UnaryMinusNode* node) {
+    node->setNode(fold(node->getNode()));
+
+    int32_t value;
+    if (getInteger(node->getNode(), value)) {
+        result_ = makeInteger((int32_t) (0u - (uint32_t) value), node);
+        delete node;
+    }
+}
+
+// NotNode --> ExprNode
+void FifthPass::visit(AST::NotNode* node) {
+    node->setNode(fold(node->getNode()));
+
+    bool value;
+    AST::NotNode* inner = dynamic_cast<AST::NotNode*>(node->getNode());
+    if (getBoolean(node->getNode(), value)) {
+        result_ = makeBoolean(!value, node);
+        delete node;
+    } else if (inner != NULL) {
+        // not not <expr> is <expr>
+        result_ = inner->getNode();
+        inner->setNode(NULL);
+        delete node;
+    }
+}
+
+// IsNullNode --> ExprNode
+void FifthPass::visit(AST::IsNullNode* node) {
+    node->setNode(fold(node->getNode()));
+}
+
+// ParExprNode --> ExprNode, parentheses have no meaning after parsing
+void FifthPass::visit(AST::ParExprNode* node) {
+    result_ = fold(node->getExpr());
+    node->setExpr(NULL);
+    delete node;
+}
+
+// BlockExprNode --> BlockNode, and unwrap blocks of a single expression
+void FifthPass::visit(AST::BlockExprNode* node) {
+    AST::BlockNode* blockNode = node->getBlock();
+    blockNode->accept(this);
+
+    std::vector<AST::ExprNode*>& exprNodes = blockNode->getExpr();
+    if (exprNodes.size() == 1) {
+        result_ = exprNodes[0];
+        exprNodes.clear();
+        delete node;
+    }
+}
+
+// ArgsNode --> ExprNode
+void FifthPass::visit(AST::ArgsNode* node) {
+    for (auto& exprNode : node->getExprs()) {
+        exprNode = fold(exprNode);
+    }
+}
+
+// CallExprNode --> ExprNode and ArgsNode
+void FifthPass::visit(AST::CallExprNode* node) {
+    node->setObjExpr(fold(node->getObjExpr()));
+
+    AST::ArgsNode* argsNode = node->getExprList();
+    if (argsNode != NULL) {
+        argsNode->accept(this);
+    }
+}
+
+int32_t FifthPass::power(int32_t base, int32_t exponent) {
+    if (exponent < 0) {
+        if (base == 1) {
+            return 1;
+        }
+        if (base == -1) {
+            return (exponent & 1) ? -1 : 1;
+        }
+        return 0;
+    }
+
+    uint32_t result = 1;
+    uint32_t square = (uint32_t) base;
+    while (exponent != 0) {
+        if (exponent & 1) {
+            result *= square;
+        }
+        square *= square;
+        exponent >>= 1;
+    }
+    return (int32_t) result;
+}
+
+// Visit an expression and return the expression that replaces it
+// The node visited sets result_ only when it is replaced, the result of the
+// operands folded by its visit is restored before
+AST::ExprNode* FifthPass::fold(AST::ExprNode* node) {
+    AST::ExprNode* parent = result_;
+
+    result_ = node;
+    node->accept(this);
+
+    AST::ExprNode* folded = result_;
+    result_ = parent;
+    return folded;
+}
+
+void FifthPass::foldOperands(AST::BinaryExprNode* node) {
+    node->setLeftExpr(fold(node->getLeftExpr()));
+    node->setRightExpr(fold(node->getRightExpr()));
+    result_ = node;
+}
+
+// Delete a binary node, except for its operand used as replacement if any
+AST::ExprNode* FifthPass::replace(AST::BinaryExprNode* node, AST::ExprNode* replacement) {
+    if (node->getLeftExpr() == replacement) {
+        node->setLeftExpr(NULL);
+    }
+    if (node->getRightExpr() == replacement) {
+        node->setRightExpr(NULL);
+    }
+    delete node;
+    return replacement;
+}
+
+// Expressions that can be removed without changing the behavior of the program
+bool FifthPass::isPure(AST::ExprNode* node) {
+    return dynamic_cast<AST::IntegerLiteralNode*>(node) != NULL
+        || dynamic_cast<AST::BooleanLiteralNode*>(node) != NULL
+        || dynamic_cast<AST::LiteralNode*>(node) != NULL
+        || dynamic_cast<AST::UnitExprNode*>(node) != NULL
+        || dynamic_cast<AST::VariableExprNode*>(node) != NULL;
+}
+
+bool FifthPass::getInteger(AST::ExprNode* node, int32_t& value) {
+    AST::IntegerLiteralNode* literal = dynamic_cast<AST::IntegerLiteralNode*>(node);
+    if (literal == NULL) {
+        return false;
+    }
+    value = literal->getValue();
+    return true;
+}
+
+bool FifthPass::getBoolean(AST::ExprNode* node, bool& value) {
+    AST::BooleanLiteralNode* literal = dynamic_cast<AST::BooleanLiteralNode*>(node);
+    if (literal == NULL) {
+        return false;
+    }
+    value = literal->getLiteral();
+    return true;
+}
+
+AST::ExprNode* FifthPass::makeInteger(int32_t value, AST::ExprNode* origin) {
+    std::string* str = new std::string(std::to_string(value));
+    AST::ExprNode* literal = new AST::IntegerLiteralNode(str, origin->getFilename(), origin->getLine(), origin->getColumn());
+    delete str;
+    literal->setTypeId(AST::TypeTable::INT32);
+    return literal;
+}
+
+AST::ExprNode* FifthPass::makeBoolean(bool value, AST::ExprNode* origin) {
+    AST::ExprNode* literal = new AST::BooleanLiteralNode(value, origin->getFilename(), origin->getLine(), origin->getColumn());
+    literal->setTypeId(AST::TypeTable::BOOL);
+    return literal;
+}
+
+AST::ExprNode* FifthPass::makeUnit(AST::ExprNode* origin) {
+    AST::ExprNode* unit = new AST::UnitExprNode(origin->getFilename(), origin->getLine(), origin->getColumn());
+    unit->setTypeId(AST::TypeTable::UNIT);
+    return unit;
+}
+
+// { <expr>; () }, to discard the value of an expression while keeping its effects
+AST::ExprNode* FifthPass::makeUnitBlock(AST::ExprNode* expr, AST::ExprNode* origin) {
+    AST::BlockNode* blockNode = new AST::BlockNode({expr, makeUnit(origin)});
+    blockNode->setTypeId(AST::TypeTable::UNIT);
+
+    AST::ExprNode* block = new AST::BlockExprNode(blockNode, origin->getFilename(), origin->getLine(), origin->getColumn());
+    block->setTypeId(AST::TypeTable::UNIT);
+    return block;
+}
+
+// unused
+void FifthPass::visit(AST::TypeNode* /*node*/) {}
+void FifthPass::visit(AST::FormalNode* /*node*/) {}
+void FifthPass::visit(AST::FormalsNode* /*node*/) {}
+void FifthPass::visit(AST::ExprNode* /*node*/) {}
+void FifthPass::visit(AST::BinaryExprNode* /*node*/) {}
+void FifthPass::visit(AST::UnaryExprNode* /*node*/) {}
+void FifthPass::visit(AST::NewExprNode* /*node*/) {}
+void FifthPass::visit(AST::VariableExprNode* /*node*/) {}
+void FifthPass::visit(AST::UnitExprNode* /*node*/) {}
+void FifthPass::visit(AST::IntegerLiteralNode* /*node*/) {}
+void FifthPass::visit(AST::LiteralNode* /*node*/) {}
+void FifthPass::visit(AST::BooleanLiteralNode* /*node*/) {}
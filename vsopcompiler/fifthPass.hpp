@@ -0,0 +1,72 @@
+#ifndef FIFTH_PASS_HPP
+#define FIFTH_PASS_HPP
+
+#include <cstdint>
+#include <string>
+#include "ast.hpp"
+
+class FifthPass : public AST::Visitor {
+public:
+    void visit(AST::ProgramNode* node) override;
+    void visit(AST::ClassNode* node) override;
+    void visit(AST::ClassBodyNode* node) override;
+    void visit(AST::FieldNode* node) override;
+    void visit(AST::MethodNode* node) override;
+    void visit(AST::BlockNode* node) override;
+    void visit(AST::IfThenElseExprNode* node) override;
+    void visit(AST::WhileDoExprNode* node) override;
+    void visit(AST::LetExprNode* node) override;
+    void visit(AST::AssignExprNode* node) override;
+    void visit(AST::AndNode* node) override;
+    void visit(AST::EqualNode* node) override;
+    void visit(AST::LowerNode* node) override;
+    void visit(AST::LowerEqualNode* node) override;
+    void visit(AST::PlusNode* node) override;
+    void visit(AST::MinusNode* node) override;
+    void visit(AST::TimesNode* node) override;
+    void visit(AST::DivNode* node) override;
+    void visit(AST::PowNode* node) override;
+    void visit(AST::UnaryMinusNode* node) override;
+    void visit(AST::NotNode* node) override;
+    void visit(AST::IsNullNode* node) override;
+    void visit(AST::ParExprNode* node) override;
+    void visit(AST::BlockExprNode* node) override;
+    void visit(AST::ArgsNode* node) override;
+    void visit(AST::CallExprNode* node) override;
+
+    // unused
+    void visit(AST::TypeNode* node) override;
+    void visit(AST::FormalNode* node) override;
+    void visit(AST::FormalsNode* node) override;
+    void visit(AST::ExprNode* node) override;
+    void visit(AST::BinaryExprNode* node) override;
+    void visit(AST::UnaryExprNode* node) override;
+    void visit(AST::NewExprNode* node) override;
+    void visit(AST::VariableExprNode* node) override;
+    void visit(AST::UnitExprNode* node) override;
+    void visit(AST::IntegerLiteralNode* node) override;
+    void visit(AST::LiteralNode* node) override;
+    void visit(AST::BooleanLiteralNode* node) override;
+
+    // int32 exponentiation with the same semantics as the generated code
+    static int32_t power(int32_t base, int32_t exponent);
+
+private:
+    // Expression replacing the last visited expression
+    AST::ExprNode* result_;
+
+    AST::ExprNode* fold(AST::ExprNode* node);
+    void foldOperands(AST::BinaryExprNode* node);
+    AST::ExprNode* replace(AST::BinaryExprNode* node, AST::ExprNode* replacement);
+
+    static bool isPure(AST::ExprNode* node);
+    static bool getInteger(AST::ExprNode* node, int32_t& value);
+    static bool getBoolean(AST::ExprNode* node, bool& value);
+
+    AST::ExprNode* makeInteger(int32_t value, AST::ExprNode* origin);
+    AST::ExprNode* makeBoolean(bool value, AST::ExprNode* origin);
+    AST::ExprNode* makeUnit(AST::ExprNode* origin);
+    AST::ExprNode* makeUnitBlock(AST::ExprNode* expr, AST::ExprNode* origin);
+};
+
+#endif // FIFTH_PASS_HPP
@@ -44,41 +44,61 @@ void FirstPass::visit(AST::ClassNode* node) {
     classInfoMap_[className] = {node, parentClassName};
 }
 
-bool FirstPass::dfs(const std::string& className, std::unordered_map<std::string, bool>& visited) {
-    if (visited.find(className) != visited.end()) {
-        return true;
-    }
+// Walk up the ancestors of each class not ordered yet, until a class already ordered, Object or an
+// undefined parent (reported by the second pass). The classes of the walk are then ordered from
+// the last one, so that each class is visited once. Reaching a class of the current walk is a cycle
+void FirstPass::checkInheritanceCycles(AST::ProgramNode* node) {
+    enum State { WALKED, ORDERED };
+    std::unordered_map<std::string, State> states;
+    std::vector<const std::string*> walk;
 
-    visited[className] = true;
+    classOrder_.clear();
+    classOrder_.reserve(classInfoMap_.size());
 
-    ClassInfo& classInfo = classInfoMap_[className];
-    if (!classInfo.parentClassName.empty()) {
-        if (dfs(classInfo.parentClassName, visited)) {
-            return true;
-        }
-    }
+    for (auto& classNode : node->getClasses()) {
+        const std::string* className = &classNode->getName();
 
-    visited.erase(className);
-    return false;
-}
+        while (states.find(*className) == states.end()) {
+            auto classIt = classInfoMap_.find(*className);
+            if (classIt == classInfoMap_.end()) {
+                break;
+            }
 
-void FirstPass::checkInheritanceCycles(AST::ProgramNode* node) {
-    std::unordered_map<std::string, bool> visited;
+            states[*className] = WALKED;
+            walk.push_back(&classIt->first);
+            className = &classIt->second.parentClassName;
+        }
 
-    for (const auto& entry : classInfoMap_) {
-        const std::string& className = entry.first;
-        
-        if (dfs(className, visited)) {
+        auto stateIt = states.find(*className);
+        if (stateIt != states.end() && stateIt->second == WALKED) {
             error(node->getFilename(), node->getLine(), node->getColumn(),
-            "Cycle detected in class inheritance involving class " + className);
+            "Cycle detected in class inheritance involving class " + *className);
+        }
+
+        while (!walk.empty()) {
+            states[*walk.back()] = ORDERED;
+            classOrder_.push_back(*walk.back());
+            walk.pop_back();
         }
     }
 }
 
+void FirstPass::updateClass(AST::ClassNode* node) {
+    // Object class is default parent class
+    if (node->getParent() == "")
+        node->setParent("Object");
+
+    classInfoMap_.at(node->getName()).classNode = node;
+}
+
 const std::unordered_map<std::string, FirstPass::ClassInfo>& FirstPass::getClassInfoMap() const {
     return classInfoMap_;
 }
 
+const std::vector<std::string>& FirstPass::getClassOrder() const {
+    return classOrder_;
+}
+
 // unused
 void FirstPass::visit(AST::TypeNode* /*node*/) {}
 void FirstPass::visit(AST::FormalNode* /*node*/) {}
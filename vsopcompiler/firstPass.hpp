@@ -4,6 +4,7 @@
 #include <iostream>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include "ast.hpp"
 
 class FirstPass : public AST::Visitor {
@@ -19,6 +20,14 @@ public:
 
     const std::unordered_map<std::string, ClassInfo>& getClassInfoMap() const;
 
+    // Object, then the classes in reverse source order (the order of the
+    // parser), a parent moved before its first child: for class A, class B
+    // extends C, class C, it is Object C B A
+    const std::vector<std::string>& getClassOrder() const;
+
+    // Replace the node of a class parsed again, with the same declaration
+    void updateClass(AST::ClassNode* node);
+
     void visit(AST::ProgramNode* node) override;
     void visit(AST::ClassNode* node) override;
 
@@ -63,8 +72,8 @@ public:
 private:
     // Map to store class information
     std::unordered_map<std::string, ClassInfo> classInfoMap_;
+    std::vector<std::string> classOrder_;
 
-    bool dfs(const std::string& className, std::unordered_map<std::string, bool>& visited);
     void checkInheritanceCycles(AST::ProgramNode* node);
 };
 
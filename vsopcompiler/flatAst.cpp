@@ -0,0 +1,517 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "flatAst.hpp"
+
+using namespace AST;
+
+/*
+    Flattening of the AST, and printing of the flat AST. The nodes of a list are flattened in source order: the
+    parser builds the lists reversed, and FourthPass reverses the blocks and the arguments in place.
+*/
+
+namespace AST {
+
+    class Flattener : public Visitor {
+        public:
+            Flattener(FlatAst& flat) : flat_(flat) {}
+
+            void visit(ProgramNode* node) override;
+            void visit(ClassNode* node) override;
+            void visit(FieldNode* node) override;
+            void visit(MethodNode* node) override;
+            void visit(FormalNode* node) override;
+            void visit(BlockNode* node) override;
+            void visit(BlockExprNode* node) override;
+            void visit(IfThenElseExprNode* node) override;
+            void visit(WhileDoExprNode* node) override;
+            void visit(LetExprNode* node) override;
+            void visit(AssignExprNode* node) override;
+            void visit(BinaryExprNode* node) override;
+            void visit(AndNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(EqualNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(LowerNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(LowerEqualNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(PlusNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(MinusNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(TimesNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(DivNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(PowNode* node) override { visit((BinaryExprNode*) node); }
+            void visit(UnaryExprNode* node) override;
+            void visit(UnaryMinusNode* node) override;
+            void visit(NotNode* node) override;
+            void visit(IsNullNode* node) override;
+            void visit(ParExprNode* node) override;
+            void visit(CallExprNode* node) override;
+            void visit(NewExprNode* node) override;
+            void visit(VariableExprNode* node) override;
+            void visit(UnitExprNode* node) override;
+            void visit(IntegerLiteralNode* node) override;
+            void visit(LiteralNode* node) override;
+            void visit(BooleanLiteralNode* node) override;
+
+            // unused, flattened by their parent
+            void visit(TypeNode* /*node*/) override {}
+            void visit(FormalsNode* /*node*/) override {}
+            void visit(ClassBodyNode* /*node*/) override {}
+            void visit(ArgsNode* /*node*/) override {}
+            void visit(ExprNode* /*node*/) override {}
+
+        private:
+            FlatAst& flat_;
+
+            std::string type(ExprNode* node) const {
+                return flat_.checked_ ? node->getTypename() : "";
+            }
+
+            // Expressions of a block or arguments, in source order
+            void visitList(std::vector<ExprNode*>& exprs);
+
+            void unary(UnaryExprNode* node, const std::string& typeStr);
+    };
+}
+
+// ProgramNode --> ClassNode, without Object
+void Flattener::visit(ProgramNode* node) {
+    std::uint32_t first = flat_.size();
+
+    const std::vector<ClassNode*>& classes = node->getClasses();
+    for (auto it = classes.rbegin(); it != classes.rend(); ++it) {
+        if ((*it)->getName() != "Object") {
+            (*it)->accept(this);
+        }
+    }
+
+    flat_.push(FlatKind::PROGRAM, first, "", "", "", 0, node->getLine(), node->getColumn());
+}
+
+// ClassNode --> FieldNode and MethodNode
+void Flattener::visit(ClassNode* node) {
+    std::uint32_t first = flat_.size();
+
+    const std::vector<FieldNode*>& fields = node->getClassBody()->getFields();
+    for (auto it = fields.rbegin(); it != fields.rend(); ++it) {
+        (*it)->accept(this);
+    }
+
+    const std::vector<MethodNode*>& methods = node->getClassBody()->getMethods();
+    for (auto it = methods.rbegin(); it != methods.rend(); ++it) {
+        (*it)->accept(this);
+    }
+
+    const std::string& parent = node->getParent().empty() ? "Object" : node->getParent();
+    flat_.push(FlatKind::CLASS, first, node->getName(), parent, "", (std::uint32_t) fields.size(),
+               node->getLine(), node->getColumn());
+}
+
+// FieldNode --> ExprNode
+void Flattener::visit(FieldNode* node) {
+    std::uint32_t first = flat_.size();
+
+    if (node->getInitExpr() != NULL) {
+        node->getInitExpr()->accept(this);
+    }
+
+    flat_.push(FlatKind::FIELD, first, node->getName(), node->getType()->getTypeStr(), "",
+               node->getInitExpr() != NULL, node->getLine(), node->getColumn());
+}
+
+// MethodNode --> FormalNode and BlockNode
+void Flattener::visit(MethodNode* node) {
+    std::uint32_t first = flat_.size();
+
+    std::vector<FormalNode*> formals;
+    if (node->getFormals() != NULL) {
+        formals = node->getFormals()->getFormals();
+    }
+    for (auto it = formals.rbegin(); it != formals.rend(); ++it) {
+        (*it)->accept(this);
+    }
+
+    BlockNode* block = node->getBlock();
+    if (block != NULL) {
+        block->accept(this);
+    } else {
+        flat_.push(FlatKind::BLOCK, flat_.size(), "", "", "", 0, 0, 0);
+    }
+
+    // Type of the last expression of the body
+    std::string bodyType;
+    if (flat_.checked_ && block != NULL) {
+        bodyType = block->getExpr().empty() ? block->getTypename() : type(block->getExpr().back());
+    }
+
+    flat_.push(FlatKind::METHOD, first, node->getName(), node->getRetType()->getTypeStr(), bodyType,
+               (std::uint32_t) formals.size(), node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(FormalNode* node) {
+    flat_.push(FlatKind::FORMAL, flat_.size(), node->getName(), node->getType()->getTypeStr(), "", 0,
+               node->getType()->getLine(), node->getType()->getColumn());
+}
+
+void Flattener::visitList(std::vector<ExprNode*>& exprs) {
+    if (flat_.checked_) {
+        for (auto& expr : exprs) {
+            expr->accept(this);
+        }
+    } else {
+        for (auto it = exprs.rbegin(); it != exprs.rend(); ++it) {
+            (*it)->accept(this);
+        }
+    }
+}
+
+// BlockNode --> ExprNode, body of a method
+void Flattener::visit(BlockNode* node) {
+    std::uint32_t first = flat_.size();
+
+    visitList(node->getExpr());
+
+    flat_.push(FlatKind::BLOCK, first, "", "", "", 0, 0, 0);
+}
+
+// BlockExprNode --> ExprNode
+void Flattener::visit(BlockExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    visitList(node->getBlock()->getExpr());
+
+    flat_.push(FlatKind::BLOCK, first, "", "", type(node), 1, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(IfThenElseExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    node->getCondExpr()->accept(this);
+    node->getThenExpr()->accept(this);
+    if (node->getElseExpr() != NULL) {
+        node->getElseExpr()->accept(this);
+    }
+
+    flat_.push(FlatKind::IF, first, "", "", type(node), node->getElseExpr() != NULL,
+               node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(WhileDoExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    node->getCondExpr()->accept(this);
+    node->getBodyExpr()->accept(this);
+
+    flat_.push(FlatKind::WHILE, first, "", "", type(node), 0, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(LetExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    if (node->getInitExpr() != NULL) {
+        node->getInitExpr()->accept(this);
+    }
+    node->getScopeExpr()->accept(this);
+
+    flat_.push(FlatKind::LET, first, node->getName(), node->getTypeNode()->getTypeStr(), type(node),
+               node->getInitExpr() != NULL, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(AssignExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    node->getExpr()->accept(this);
+
+    flat_.push(FlatKind::ASSIGN, first, node->getNameStr(), "", type(node), 0, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(BinaryExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    node->getLeftExpr()->accept(this);
+    node->getRightExpr()->accept(this);
+
+    flat_.push(FlatKind::BINARY, first, "", "", type(node), (std::uint32_t) node->getOp(),
+               node->getLine(), node->getColumn());
+}
+
+void Flattener::unary(UnaryExprNode* node, const std::string& typeStr) {
+    std::uint32_t first = flat_.size();
+
+    node->getNode()->accept(this);
+
+    flat_.push(FlatKind::UNARY, first, "", "", flat_.checked_ ? typeStr : "", (std::uint32_t) node->getOperator(),
+               node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(UnaryExprNode* node) {
+    unary(node, "bool");
+}
+
+void Flattener::visit(UnaryMinusNode* node) {
+    unary(node, "int32");
+}
+
+void Flattener::visit(NotNode* node) {
+    unary(node, "bool");
+}
+
+void Flattener::visit(IsNullNode* node) {
+    unary(node, type(node));
+}
+
+void Flattener::visit(ParExprNode* node) {
+    node->getExpr()->accept(this);
+}
+
+// CallExprNode --> object and arguments
+void Flattener::visit(CallExprNode* node) {
+    std::uint32_t first = flat_.size();
+
+    node->getObjExpr()->accept(this);
+    visitList(node->getExprList()->getExprs());
+
+    flat_.push(FlatKind::CALL, first, node->getMethodName(), "", type(node), 0, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(NewExprNode* node) {
+    flat_.push(FlatKind::NEW, flat_.size(), node->getTypeName(), "", type(node), 0, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(VariableExprNode* node) {
+    flat_.push(FlatKind::VARIABLE, flat_.size(), node->getVariableName(), "", type(node), 0,
+               node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(UnitExprNode* node) {
+    flat_.push(FlatKind::UNIT, flat_.size(), "", "", flat_.checked_ ? "unit" : "", 0, node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(IntegerLiteralNode* node) {
+    flat_.push(FlatKind::INTEGER, flat_.size(), node->getIntegerLiteral(), "", flat_.checked_ ? "int32" : "", 0,
+               node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(LiteralNode* node) {
+    flat_.push(FlatKind::STRING, flat_.size(), node->getLiteral(), "", flat_.checked_ ? "string" : "", 0,
+               node->getLine(), node->getColumn());
+}
+
+void Flattener::visit(BooleanLiteralNode* node) {
+    flat_.push(FlatKind::BOOLEAN, flat_.size(), "", "", flat_.checked_ ? "bool" : "", node->getLiteral(),
+               node->getLine(), node->getColumn());
+}
+
+FlatAst::FlatAst(ProgramNode* program, bool checked) : checked_(checked) {
+    strings_.push_back("");
+
+    Flattener flattener(*this);
+    program->accept(&flattener);
+}
+
+std::uint32_t FlatAst::intern(const std::string& s) {
+    if (s.empty()) {
+        return 0;
+    }
+
+    auto it = stringIds_.find(s);
+    if (it != stringIds_.end()) {
+        return it->second;
+    }
+
+    std::uint32_t id = (std::uint32_t) strings_.size();
+    strings_.push_back(s);
+    stringIds_.emplace(s, id);
+
+    return id;
+}
+
+std::uint32_t FlatAst::push(FlatKind kind, std::uint32_t first, const std::string& name, const std::string& declared,
+                            const std::string& type, std::uint32_t aux, int line, int column) {
+    std::uint32_t i = size();
+
+    kinds_.push_back((std::uint8_t) kind);
+    sizes_.push_back(i - first + 1);
+    names_.push_back(intern(name));
+    declared_.push_back(intern(declared));
+    types_.push_back(intern(type));
+    aux_.push_back(aux);
+    positions_.push_back((std::uint64_t) (std::uint32_t) line << 32 | (std::uint32_t) column);
+
+    return i;
+}
+
+void FlatAst::children(std::uint32_t i, std::vector<std::uint32_t>& out) const {
+    std::uint32_t first = i + 1 - sizes_[i];
+
+    for (std::uint32_t child = i; child > first; ) {
+        child -= 1;
+        out.push_back(child);
+        child -= sizes_[child] - 1;
+    }
+}
+
+std::string FlatAst::evaluate() const {
+    std::string out;
+    std::vector<std::uint32_t> scratch;
+
+    print(root(), out, scratch);
+
+    return out;
+}
+
+// Print count children of a node as a list, after skipping the first ones
+void FlatAst::printList(std::uint32_t i, std::size_t skip, std::size_t count, std::string& out,
+                        std::vector<std::uint32_t>& scratch) const {
+    std::size_t base = scratch.size();
+    children(i, scratch);
+
+    // The children are from the last one, the nested lists are above them
+    std::size_t last = scratch.size() - 1 - skip;
+
+    out += '[';
+    for (std::size_t k = 0; k < count; ++k) {
+        if (k > 0) {
+            out += ", ";
+        }
+        print(scratch[last - k], out, scratch);
+    }
+    out += ']';
+
+    scratch.resize(base);
+}
+
+void FlatAst::print(std::uint32_t i, std::string& out, std::vector<std::uint32_t>& scratch) const {
+    std::size_t base = scratch.size();
+    children(i, scratch);
+
+    std::size_t count = scratch.size() - base;
+    std::size_t last = scratch.size() - 1;
+
+    // k-th child in source order
+    auto child = [&](std::size_t k) { return scratch[last - k]; };
+
+    switch (kind(i)) {
+        case FlatKind::PROGRAM:
+            printList(i, 0, count, out, scratch);
+            break;
+
+        case FlatKind::CLASS:
+            out += "Class(" + name(i) + ", " + declared(i) + ", ";
+            printList(i, 0, aux(i), out, scratch);
+            out += ", ";
+            printList(i, aux(i), count - aux(i), out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::FIELD:
+            out += "Field(" + name(i) + ", " + declared(i);
+            if (aux(i)) {
+                out += ", ";
+                print(child(0), out, scratch);
+            }
+            out += ')';
+            break;
+
+        case FlatKind::METHOD:
+            out += "Method(" + name(i) + ", ";
+            printList(i, 0, aux(i), out, scratch);
+            out += ", " + declared(i) + ", ";
+            print(child(aux(i)), out, scratch);
+            if (checked_) {
+                out += " : " + type(i);
+            }
+            out += ')';
+            break;
+
+        case FlatKind::FORMAL:
+            out += name(i) + " : " + declared(i);
+            break;
+
+        case FlatKind::BLOCK:
+            printList(i, 0, count, out, scratch);
+            break;
+
+        case FlatKind::IF:
+            out += "If(";
+            print(child(0), out, scratch);
+            out += ", ";
+            print(child(1), out, scratch);
+            if (aux(i)) {
+                out += ", ";
+                print(child(2), out, scratch);
+            }
+            out += ')';
+            break;
+
+        case FlatKind::WHILE:
+            out += "While(";
+            print(child(0), out, scratch);
+            out += ", ";
+            print(child(1), out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::LET:
+            out += "Let(" + name(i) + ", " + declared(i) + ", ";
+            if (aux(i)) {
+                print(child(0), out, scratch);
+                out += ", ";
+            }
+            print(child(aux(i)), out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::ASSIGN:
+            out += "Assign(" + name(i) + ", ";
+            print(child(0), out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::BINARY:
+            out += "BinOp(" + operatorToString((Operator) aux(i)) + ", ";
+            print(child(0), out, scratch);
+            out += ", ";
+            print(child(1), out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::UNARY:
+            out += "UnOp(" + operatorToString((Operator) aux(i)) + ", ";
+            print(child(0), out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::CALL:
+            out += "Call(";
+            print(child(0), out, scratch);
+            out += ", " + name(i) + ", ";
+            printList(i, 1, count - 1, out, scratch);
+            out += ')';
+            break;
+
+        case FlatKind::NEW:
+            out += "New(" + name(i) + ')';
+            break;
+
+        case FlatKind::VARIABLE:
+        case FlatKind::INTEGER:
+        case FlatKind::STRING:
+            out += name(i);
+            break;
+
+        case FlatKind::UNIT:
+            out += "()";
+            break;
+
+        case FlatKind::BOOLEAN:
+            out += aux(i) ? "true" : "false";
+            break;
+    }
+
+    // Type of a checked expression
+    bool expression = kind(i) > FlatKind::FORMAL && !(kind(i) == FlatKind::BLOCK && !aux(i));
+    if (checked_ && expression) {
+        out += " : " + type(i);
+    }
+
+    scratch.resize(base);
+}
@@ -0,0 +1,123 @@
+#ifndef FLAT_AST_HPP
+#define FLAT_AST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+
+namespace AST {
+
+    enum class FlatKind : std::uint8_t {
+        PROGRAM,
+        CLASS,
+        FIELD,
+        METHOD,
+        FORMAL,
+        BLOCK,
+        IF,
+        WHILE,
+        LET,
+        ASSIGN,
+        BINARY,
+        UNARY,
+        CALL,
+        NEW,
+        VARIABLE,
+        UNIT,
+        INTEGER,
+        STRING,
+        BOOLEAN
+    };
+
+    /*
+    *   The AST in contiguous arrays, a node is a 32-bit index.
+    *
+    *   The nodes are in post-order, the children of a node in source order
+    *   just before it: the last child of i is i - 1, and the child before c
+    *   is c - size(c). A pass computing a node from its children is a single
+    *   loop over the indices. Parentheses are not kept.
+    *
+    *   Node     name        declared      aux              children
+    *   PROGRAM                                             classes
+    *   CLASS    class       parent        fields count     fields, methods
+    *   FIELD    field       type          has initializer  initializer
+    *   METHOD   method      return type   formals count    formals, body BLOCK
+    *   FORMAL   formal      type
+    *   BLOCK                              is expression    expressions
+    *   IF                                 has else         cond, then, else
+    *   WHILE                                               cond, body
+    *   LET      variable    type          has initializer  initializer, scope
+    *   ASSIGN   variable                                   value
+    *   BINARY                             Operator         left, right
+    *   UNARY                              Operator         operand
+    *   CALL     method                                     object, arguments
+    *   NEW      class
+    *   VARIABLE variable
+    *   INTEGER  literal
+    *   STRING   literal
+    *   BOOLEAN                            value
+    *
+    *   The names are indices in a table of strings.
+    */
+    class FlatAst {
+        public:
+            // Flatten a program, without Object. If checked, FourthPass ran on
+            // it: the types of the expressions are kept, and its blocks and
+            // arguments are already in source order.
+            FlatAst(ProgramNode* program, bool checked);
+
+            // Same output as ProgramNode::evaluate()
+            std::string evaluate() const;
+
+            std::uint32_t size() const { return (std::uint32_t) kinds_.size(); }
+            std::uint32_t root() const { return size() - 1; }
+
+            FlatKind kind(std::uint32_t i) const { return (FlatKind) kinds_[i]; }
+            std::uint32_t subtreeSize(std::uint32_t i) const { return sizes_[i]; }
+            std::uint32_t aux(std::uint32_t i) const { return aux_[i]; }
+
+            const std::string& name(std::uint32_t i) const { return strings_[names_[i]]; }
+            const std::string& declared(std::uint32_t i) const { return strings_[declared_[i]]; }
+
+            // Type of an expression, or of the body of a method, if checked
+            const std::string& type(std::uint32_t i) const { return strings_[types_[i]]; }
+
+            int line(std::uint32_t i) const { return (int) (positions_[i] >> 32); }
+            int column(std::uint32_t i) const { return (int) (positions_[i] & 0xffffffff); }
+
+            // Append the children of a node, from the last one
+            void children(std::uint32_t i, std::vector<std::uint32_t>& out) const;
+
+        private:
+            friend class Flattener;
+
+            bool checked_;
+
+            std::vector<std::uint8_t> kinds_;
+            std::vector<std::uint32_t> sizes_;
+            std::vector<std::uint32_t> names_;
+            std::vector<std::uint32_t> declared_;
+            std::vector<std::uint32_t> types_;
+            std::vector<std::uint32_t> aux_;
+            std::vector<std::uint64_t> positions_;
+
+            // Index 0 is the empty string
+            std::vector<std::string> strings_;
+            std::unordered_map<std::string, std::uint32_t> stringIds_;
+
+            std::uint32_t intern(const std::string& s);
+
+            // Add a node after its children, which start at first
+            std::uint32_t push(FlatKind kind, std::uint32_t first, const std::string& name, const std::string& declared,
+                               const std::string& type, std::uint32_t aux, int line, int column);
+
+            void print(std::uint32_t i, std::string& out, std::vector<std::uint32_t>& scratch) const;
+            void printList(std::uint32_t i, std::size_t skip, std::size_t count, std::string& out,
+                           std::vector<std::uint32_t>& scratch) const;
+    };
+}
+
+#endif // FLAT_AST_HPP
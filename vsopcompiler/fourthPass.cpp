@@ -7,14 +7,19 @@
     Fourth pass to perform type checking
 */
 
-const std::unordered_map<std::string, AST::Type> FourthPass::type_map_ = {
-    {"int32", AST::Type::INT32},
-    {"bool", AST::Type::BOOL},
-    {"string", AST::Type::STRING},
-    {"unit", AST::Type::UNIT}
-};
+FourthPass::FourthPass(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes, TypeTable& types): classInfoMap_(classInfoMap), classMethodTypes_(classMethodTypes), classFieldTypes_(classFieldTypes), classMethodFormalsTypes_(classMethodFormalsTypes), types_(types), currentClassId_(TypeTable::OBJECT), currentLetType_(TypeTable::UNIT), inField_(false), dependencies_(nullptr) {
 
-FourthPass::FourthPass(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes): classInfoMap_(classInfoMap), classMethodTypes_(classMethodTypes), classFieldTypes_(classFieldTypes), classMethodFormalsTypes_(classMethodFormalsTypes) {}
+    // Parent of each class by type id, the other types are left to UNIT
+    for (const auto& entry : classInfoMap_) {
+        TypeId id = types_.intern(entry.first);
+        if (id >= parents_.size()) {
+            parents_.resize(id + 1, TypeTable::UNIT);
+        }
+        if (id != TypeTable::OBJECT) {
+            parents_[id] = types_.intern(entry.second.parentClassName);
+        }
+    }
+}
 
 // ProgramNode --> ClassNode
 void FourthPass::visit(ProgramNode* node) {
@@ -25,9 +30,46 @@ void FourthPass::visit(ProgramNode* node) {
     }
 }
 
+// FieldNode alone, recording its dependencies
+void FourthPass::checkField(ClassNode* classNode, FieldNode* node, std::unordered_set<std::string>& dependencies) {
+    currentClassName_ = classNode->getName();
+    currentClassId_ = types_.intern(currentClassName_);
+    inField_ = false;
+    dependencies_ = &dependencies;
+    depend(currentClassName_);
+
+    try {
+        node->accept(this);
+    } catch (...) {
+        dependencies_ = nullptr;
+        throw;
+    }
+
+    dependencies_ = nullptr;
+}
+
+// MethodNode alone, recording its dependencies
+void FourthPass::checkMethod(ClassNode* classNode, MethodNode* node, std::unordered_set<std::string>& dependencies) {
+    currentClassName_ = classNode->getName();
+    currentClassId_ = types_.intern(currentClassName_);
+    inField_ = false;
+    dependencies_ = &dependencies;
+    depend(currentClassName_);
+
+    try {
+        node->accept(this);
+    } catch (...) {
+        dependencies_ = nullptr;
+        throw;
+    }
+
+    dependencies_ = nullptr;
+}
+
 // ClassNode --> ClassBodyNode
 void FourthPass::visit(ClassNode* node) {
     currentClassName_ = node->getName();
+    currentClassId_ = types_.intern(currentClassName_);
 
     AST::ClassBodyNode* classBodyNode = node->getClassBody();
     if (classBodyNode != NULL) {
@@ -88,62 +130,17 @@ void FourthPass::visit(IfThenElseExprNode* node) {
 
         // Both branch of same type
         if (thenType == elseType) {
-            node->setType(thenType);
-
-            if (thenType == Type::BOOL)
-                node->setTypename("bool");
-            if (thenType == Type::STRING)
-                node->setTypename("string");
-            if (thenType == Type::INT32)
-                node->setTypename("int32");
-
-            // type of the first common ancestor of the two branches
             if (thenType == Type::CLASS) {
-                if (elseExprNode->getTypename() == thenExprNode->getTypename()) {
-                    node->setTypename(elseExprNode->getTypename());
-                } else {
-                    std::string classElse = elseExprNode->getTypename();
-                    std::string classThen = thenExprNode->getTypename();
-
-                    std::unordered_set<std::string> ancestors1;
-                    std::unordered_set<std::string> ancestors2;
-
-                    // Stock all ancestor of first class
-                    std::string currentClass = classElse;
-                    while (currentClass != "Object") {
-                        ancestors1.insert(currentClass);
-                        currentClass = classInfoMap_.at(currentClass).parentClassName;
-                    }
-
-                    // Stock all ancestor of second class
-                    currentClass = classThen;
-                    while (currentClass != "Object") {
-                        ancestors2.insert(currentClass);
-                        currentClass = classInfoMap_.at(currentClass).parentClassName;
-                    }
-
-                    // Find first common ancestor
-                    currentClass = classElse;
-                    while (currentClass != "Object") {
-                        if (ancestors2.find(currentClass) != ancestors2.end()) {
-                            node->setTypename(currentClass);
-                            break;
-                        }
-                        currentClass = classInfoMap_.at(currentClass).parentClassName;
-                    }
-
-                    // First common ancestor is the root class Object
-                    if (currentClass == "Object") {
-                        node->setTypename("Object");
-                    }
-                }
+                // type of the first common ancestor of the two branches
+                node->setTypeId(commonAncestor(thenExprNode->getTypeId(), elseExprNode->getTypeId()), types_);
+            } else {
+                node->setTypeId(thenExprNode->getTypeId(), types_);
             }
-        } 
+        }
 
         // At least one branch is unit
         if (thenType == Type::UNIT || elseType == Type::UNIT) {
-            node->setType(Type::UNIT);
-            node->setTypename("unit");
+            node->setTypeId(TypeTable::UNIT);
             return;
         }
         // error
@@ -159,8 +156,7 @@ void FourthPass::visit(IfThenElseExprNode* node) {
             without an else branch is just a shortcut for
             if <cond> then <expr_t> else ()
         */
-        node->setType(Type::UNIT);
-        node->setTypename("unit");  
+        node->setTypeId(TypeTable::UNIT);  
     }
 }
 
@@ -187,8 +183,7 @@ void FourthPass::visit(WhileDoExprNode* node) {
     }
     
     // set type of the loop to unit
-    node->setType(Type::UNIT);
-    node->setTypename("unit");
+    node->setTypeId(TypeTable::UNIT);
 }
 
 // LetExprNode --> TypeNode and ExprNode
@@ -196,8 +191,8 @@ void FourthPass::visit(LetExprNode* node) {
     
     currentLetVar_= node->getName();
     node->getTypeNode()->accept(this);
-    currentTypeLetVar_ = node->getTypeNode()->getType();
-    currentLetTypename_ = node->getTypeNode()->getTypeStr();
+    currentLetType_ = types_.intern(node->getTypeNode()->getTypeStr());
+    depend(currentLetType_);
     
     AST::ExprNode* initExprNode = node->getInitExpr();
     if (initExprNode != NULL) {
@@ -214,13 +209,12 @@ void FourthPass::visit(LetExprNode* node) {
             }
         } else {
             if (initExprNode->getType() == Type::CLASS) {
-                std::string name = initExprNode->getTypename();
-                auto parentIt = classInfoMap_.find(initExprNode->getTypename());
-                if (parentIt != classInfoMap_.end()) {
-                    name = parentIt->second.parentClassName;            
+                TypeId initType = initExprNode->getTypeId();
+                if (isClassDefined(initType)) {
+                    initType = parentOf(initType);
                 }
             
-                if (name != typeNode->getTypeStr()) {
+                if (initType != types_.intern(typeNode->getTypeStr())) {
                     error(node->getFilename(), node->getLine(), node->getColumn(),
                     "Init expression and Type expression must be of the same type in Let");
                 }
@@ -231,13 +225,7 @@ void FourthPass::visit(LetExprNode* node) {
         if (scopeExprNode != NULL) {
             scopeExprNode->accept(this);
 
-            if (scopeExprNode->getType() == Type::CLASS) {
-                node->setType(scopeExprNode->getType());
-                node->setTypename(scopeExprNode->getTypename());
-            } else {
-                node->setType(scopeExprNode->getType());
-                node->setTypename(scopeExprNode->getTypename());
-            }
+            node->setTypeId(scopeExprNode->getTypeId(), types_);
         }
     } else {
         
@@ -245,13 +233,7 @@ void FourthPass::visit(LetExprNode* node) {
         if (scopeExprNode != NULL) {
             scopeExprNode->accept(this);
 
-            if (scopeExprNode->getType() == Type::CLASS) {
-                node->setType(scopeExprNode->getType());
-                node->setTypename(scopeExprNode->getTypename());
-            } else {
-                node->setType(scopeExprNode->getType());
-                node->setTypename(scopeExprNode->getTypename());
-            }
+            node->setTypeId(scopeExprNode->getTypeId(), types_);
         }
     }
 }
@@ -277,38 +259,19 @@ void FourthPass::visit(AssignExprNode* node) {
                     auto formalIt = methodIt->second.find(node->getNameStr());
                     if (formalIt != methodIt->second.end()) {
 
-                        Type idType = Type::CLASS;
-
-                        const auto it = type_map_.find(formalIt->second);
-                        if (it != type_map_.end()) {
-                            idType = it->second;
-                        } else {
-                            idType = Type::CLASS;
-                        }
+                        Type idType = TypeTable::kind(types_.intern(formalIt->second));
 
                         if (exprNode->getType() != idType) {
                             error(node->getFilename(), node->getLine(), node->getColumn(),
                             "Expression must be of same type as name type in Assign");
                         }
 
-                        if (exprNode->getType() == Type::CLASS) {
-                            node->setType(exprNode->getType());
-                            node->setTypename(exprNode->getTypename());
-                        } else {
-                            node->setType(exprNode->getType());
-                            node->setTypename(exprNode->getTypename());
-                        }
+                        node->setTypeId(exprNode->getTypeId(), types_);
                     }
                 }
             }
         }
-        if (exprNode->getType() == Type::CLASS) {
-            node->setType(exprNode->getType());
-            node->setTypename(exprNode->getTypename());
-        } else {
-            node->setType(exprNode->getType());
-            node->setTypename(exprNode->getTypename());
-        }
+        node->setTypeId(exprNode->getTypeId(), types_);
     }
 }
 
@@ -339,8 +302,7 @@ void FourthPass::visit(AndNode* node) {
         }
     }
 
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
 }
 
 // EqualNode --> ExprNode
@@ -365,8 +327,7 @@ void FourthPass::visit(EqualNode* node) {
         "error different primitive types");
     }
 
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
 }
 
 // LowerNode --> ExprNode
@@ -387,8 +348,7 @@ void FourthPass::visit(LowerNode* node) {
         "Expression must be of type int32 in < ");
     }
 
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
 }
 
 // LowerEqualNode --> ExprNode
@@ -409,8 +369,7 @@ void FourthPass::visit(LowerEqualNode* node) {
         "Expression must be of type int32 in <= ");
     }
 
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
 }
 
 // PlusNode --> ExprNode
@@ -431,8 +390,7 @@ void FourthPass::visit(PlusNode* node) {
         "Expression must be of type int32 in + ");
     }
 
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 // MinusNode --> ExprNode
@@ -453,8 +411,7 @@ void FourthPass::visit(MinusNode* node) {
         "Expression must be of type int32 in - ");
     }
 
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 // TimesNode --> ExprNode
@@ -475,8 +432,7 @@ void FourthPass::visit(TimesNode* node) {
         "Expression must be of type int32 in * ");
     }
 
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 // DivNode --> ExprNode
@@ -497,8 +453,7 @@ void FourthPass::visit(DivNode* node) {
         "Expression must be of type int32 in / ");
     }
 
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 // PowNode --> ExprNode
@@ -519,8 +474,7 @@ void FourthPass::visit(PowNode* node) {
         "Expression must be of type int32 in ^ ");
     }
 
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 // UnaryExprNode --> ExprNode
@@ -538,8 +492,7 @@ void FourthPass::visit(UnaryMinusNode* node) {
         }
     }
 
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 // NotNode --> ExprNode
@@ -550,8 +503,7 @@ void FourthPass::visit(NotNode* node) {
         exprNode->accept(this);
     }
 
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
 }
 
 // IsNullNode --> ExprNode
@@ -561,22 +513,20 @@ void FourthPass::visit(IsNullNode* node) {
     if (exprNode != NULL) {
         exprNode->accept(this);
 
-        if (exprNode->getType() != Type::CLASS && exprNode->getTypename() != "Object") {
+        if (exprNode->getType() != Type::CLASS) {
             error(exprNode->getFilename(), exprNode->getLine(), exprNode->getColumn(), "this literal has type " + exprNode->getTypename() + ", but expected type was Object.");
         }
     }
 
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
 }
 
 void FourthPass::visit(NewExprNode* node) {
     
-    node->setType(Type::CLASS);
-    node->setTypename(node->getTypeName()); //getTypeName is from NewExprNode, getTypename is from ExprNode
+    node->setTypeId(types_.intern(node->getTypeName()), types_); //getTypeName is from NewExprNode, getTypeId is from ExprNode
 
     // Check
-    if (!isClassDefined(node->getTypename())) {
+    if (!isClassDefined(node->getTypeId())) {
         error(node->getFilename(), node->getLine(), node->getColumn(), "Undefined type " + node->getTypeName());
     }
 }
@@ -597,19 +547,16 @@ void FourthPass::visit(VariableExprNode* node) {
             error(node->getFilename(), node->getLine(), node->getColumn(), "Cannot use self in field initializer.");
         }
 
-        node->setType(Type::CLASS);
-        node->setTypename(currentClassName_);
+        node->setTypeId(currentClassId_, types_);
 
     } else {
 
         // Check variable in let
         if (!currentLetVar_.empty()) {
 
-            // if (currentLetVar_ == node->getVariableName() && node->getType() == currentTypeLetVar_ && node->getTypename() == currentLetTypename_) {
             if (currentLetVar_ == node->getVariableName()) {
                 
-                node->setType(currentTypeLetVar_);
-                node->setTypename(currentLetTypename_);
+                node->setTypeId(currentLetType_, types_);
 
                 return;
             }
@@ -619,7 +566,7 @@ void FourthPass::visit(VariableExprNode* node) {
         std::string methodName = currentMethodName_;
 
         // loop walks up class hierarchy
-        while (classInfoMap_.find(currentClass) != classInfoMap_.end()) {
+        while (isClassDefined(currentClass)) {
 
             // check if currentClass in classMethodTypes_ --> does the class have methods?
             if (classMethodTypes_.find(currentClass) != classMethodTypes_.end()) {
@@ -640,14 +587,7 @@ void FourthPass::visit(VariableExprNode* node) {
                             if (formalIt != methodIt->second.end()) {
 
                                 // check if it (= Type) in classMethodFormalsTypes_ at formalIt (= Formal) at currentMethodName_ at currentClassName_
-                                const auto it = type_map_.find(formalIt->second);
-                                if (it != type_map_.end()) {
-                                    node->setType(it->second);
-                                    node->setTypename(it->first);
-                                } else {
-                                    node->setType(Type::CLASS);
-                                    node->setTypename(formalIt->second);
-                                }
+                                node->setTypeId(types_.intern(formalIt->second), types_);
 
                                 return;
                             } else {
@@ -665,14 +605,7 @@ void FourthPass::visit(VariableExprNode* node) {
                                         }
 
                                         // check if it (= Type) in classFieldTypes_ at fieldIt (= Field) at currentClass
-                                        const auto it = type_map_.find(fieldIt->second);
-                                        if (it != type_map_.end()) {
-                                            node->setType(it->second);
-                                            node->setTypename(it->first);
-                                        } else {
-                                            node->setType(Type::CLASS);
-                                            node->setTypename(fieldIt->second);
-                                        }
+                                        node->setTypeId(types_.intern(fieldIt->second), types_);
                                         return;
                                     }
                                 }
@@ -692,14 +625,7 @@ void FourthPass::visit(VariableExprNode* node) {
                                     }
 
                                     // check if it (= Type) in classFieldTypes_ at fieldIt (= Field) at currentClass
-                                    const auto it = type_map_.find(fieldIt->second);
-                                    if (it != type_map_.end()) {
-                                        node->setType(it->second);
-                                        node->setTypename(it->first);
-                                    } else {
-                                        node->setType(Type::CLASS);
-                                        node->setTypename(fieldIt->second);
-                                    }
+                                    node->setTypeId(types_.intern(fieldIt->second), types_);
 
                                     return;
                                 }
@@ -720,14 +646,7 @@ void FourthPass::visit(VariableExprNode* node) {
                                 }
 
                                 // check if it (= Type) in classFieldTypes_ at fieldIt (= Field) at currentClass
-                                const auto it = type_map_.find(fieldIt->second);
-                                if (it != type_map_.end()) {
-                                    node->setType(it->second);
-                                    node->setTypename(it->first);
-                                } else {
-                                    node->setType(Type::CLASS);
-                                    node->setTypename(fieldIt->second);
-                                }
+                                node->setTypeId(types_.intern(fieldIt->second), types_);
 
                                 return;
                             }
@@ -750,14 +669,7 @@ void FourthPass::visit(VariableExprNode* node) {
                             }
 
                             // check if it (= Type) in classFieldTypes_ at fieldIt (= Field) at currentClass
-                            const auto it = type_map_.find(fieldIt->second);
-                            if (it != type_map_.end()) {
-                                node->setType(it->second);
-                                node->setTypename(it->first);
-                            } else {
-                                node->setType(Type::CLASS);
-                                node->setTypename(fieldIt->second);
-                            }
+                            node->setTypeId(types_.intern(fieldIt->second), types_);
                             return;
                         }
                     }
@@ -778,32 +690,22 @@ void FourthPass::visit(VariableExprNode* node) {
                         }
 
                         // check if it (= Type) in classFieldTypes_ at fieldIt (= Field) at currentClass
-                        const auto it = type_map_.find(fieldIt->second);
-                        if (it != type_map_.end()) {
-                            node->setType(it->second);
-                            node->setTypename(it->first);
-                        } else {
-                            node->setType(Type::CLASS);
-                            node->setTypename(fieldIt->second);
-                        }
+                        node->setTypeId(types_.intern(fieldIt->second), types_);
                         return;
                     }
                 }
             }
-            currentClass = classInfoMap_.at(currentClass).parentClassName;
+            currentClass = parentOf(currentClass);
         }
     }
 
-    if (type_map_.find(node->getTypename()) == type_map_.end()) {
-        if (node->getType() != AST::Type::CLASS) {
-            error(node->getFilename(), node->getLine(), node->getColumn(), "Use of unbound variable " + node->getVariableName() + ".");
-        }
+    if (node->getType() != AST::Type::CLASS) {
+        error(node->getFilename(), node->getLine(), node->getColumn(), "Use of unbound variable " + node->getVariableName() + ".");
     }
 }
 
 void FourthPass::visit(UnitExprNode* node) {
-    node->setType(Type::UNIT);
-    node->setTypename("unit");
+    node->setTypeId(TypeTable::UNIT);
 }
 
 // ParExprNode --> ExprNode
@@ -814,13 +716,7 @@ void FourthPass::visit(ParExprNode* node) {
         exprNode->accept(this);
     }
 
-    if (exprNode->getType() == Type::CLASS) {
-        node->setType(exprNode->getType());
-        node->setTypename(exprNode->getTypename());
-    } else {
-        node->setType(exprNode->getType());
-        node->setTypename(exprNode->getTypename());
-    }
+    node->setTypeId(exprNode->getTypeId(), types_);
 }
 
 // BlockExprNode --> BlockNode
@@ -829,8 +725,7 @@ void FourthPass::visit(BlockExprNode* node) {
     AST::BlockNode* blockNode = node->getBlock();
     if (blockNode != NULL) {
         blockNode->accept(this);
-        node->setType(blockNode->getType());
-        node->setTypename(blockNode->getTypename());
+        node->setTypeId(blockNode->getTypeId(), types_);
     }
 }
 
@@ -842,8 +737,7 @@ void FourthPass::visit(BlockNode* node) {
     std::reverse(exprNodes.begin(), exprNodes.end());
     for (auto& expr_node : exprNodes) {
         expr_node->accept(this);
-        node->setType(expr_node->getType());
-        node->setTypename(expr_node->getTypename());
+        node->setTypeId(expr_node->getTypeId(), types_);
     }
 }
 
@@ -863,6 +757,11 @@ void FourthPass::visit(FieldNode* node) {
     
     inField_ = true;
 
+    // Nothing of the method or the field visited before is in scope
+    currentMethodName_ = "";
+    currentLetVar_ = "";
+    currentLetType_ = TypeTable::UNIT;
+
     AST::TypeNode* typeNode = node->getType();
     // if (typeNode != NULL) {
     //     typeNode->accept(this);
@@ -884,22 +783,9 @@ void FourthPass::visit(FieldNode* node) {
         }
 
         // Error if not the same class
-        if (typeNode->getType() == Type::CLASS && (typeNode->getTypeStr() != initExprNode->getTypename())) {
-
-            std::unordered_set<std::string> ancestors;
-
-            // Stock all ancestor of class
-            std::string currentClass = initExprNode->getTypename();
-            while (currentClass != "Object") {
-                ancestors.insert(currentClass);
-                currentClass = classInfoMap_.at(currentClass).parentClassName;
-            }
-            ancestors.insert("Object");
-
-            if (ancestors.find(typeNode->getTypeStr()) == ancestors.end()) {
-                error(initExprNode->getFilename(), initExprNode->getLine(), initExprNode->getColumn(),
-                    "The type of the initializer must conform to the type of the field ");
-            }
+        if (typeNode->getType() == Type::CLASS && !conforms(initExprNode->getTypeId(), types_.intern(typeNode->getTypeStr()))) {
+            error(initExprNode->getFilename(), initExprNode->getLine(), initExprNode->getColumn(),
+                "The type of the initializer must conform to the type of the field ");
         }
     }
 
@@ -910,9 +796,9 @@ void FourthPass::visit(FieldNode* node) {
 void FourthPass::visit(MethodNode* node) {
     currentMethodName_ = node->getName();
 
-    // reset currentLetVar_  and currentLetTypename_ 
+    // reset currentLetVar_  and currentLetType_ 
     currentLetVar_ = "";
-    currentLetTypename_ = "";
+    currentLetType_ = TypeTable::UNIT;
 
     AST::TypeNode* retTypeNode =  node->getRetType();
     if (retTypeNode != NULL) {
@@ -935,22 +821,10 @@ void FourthPass::visit(MethodNode* node) {
     }
 
     // Error if not the same class
-    if (currentClassName_ != "Object" && (retTypeNode->getType() == blockNode->getType()) && retTypeNode->getType() == Type::CLASS && (retTypeNode->getTypeStr() != blockNode->getTypename())) {
-
-        std::unordered_set<std::string> ancestors;
-
-        // Stock all ancestor of class
-        std::string currentClass = blockNode->getTypename();
-        while (currentClass != "Object") {
-            ancestors.insert(currentClass);
-            currentClass = classInfoMap_.at(currentClass).parentClassName;
-        }
-        ancestors.insert("Object");
-
-        if (ancestors.find(retTypeNode->getTypeStr()) == ancestors.end()) {
-            error(node->getFilename(), node->getLine(), node->getColumn(),
-                "The type of the method body must conform to its declared return type.");
-        }
+    if (currentClassName_ != "Object" && (retTypeNode->getType() == blockNode->getType()) && retTypeNode->getType() == Type::CLASS
+        && !conforms(blockNode->getTypeId(), types_.intern(retTypeNode->getTypeStr()))) {
+        error(node->getFilename(), node->getLine(), node->getColumn(),
+            "The type of the method body must conform to its declared return type.");
     }
 }
 
@@ -1004,12 +878,11 @@ void FourthPass::visit(CallExprNode* node) {
     }
 
     if (objExprNode->getTypename() == "self") {
-        node->setType(Type::CLASS);
-        node->setTypename("self");
+        node->setTypeId(objExprNode->getTypeId(), types_);
     } else {
         
         // loop walks up class hierarchy
-        while (classInfoMap_.find(currentClass) != classInfoMap_.end()) {
+        while (isClassDefined(currentClass)) {
 
             
             // check if currentClass in classMethodTypes_
@@ -1039,10 +912,10 @@ void FourthPass::visit(CallExprNode* node) {
                                 int i = 0;
                                 for (auto formal : methodIt->second) {
 
-                                    const auto it = type_map_.find(formal.second);
-                                    if (it != type_map_.end()) {
+                                    TypeId formalType = types_.intern(formal.second);
+                                    if (TypeTable::kind(formalType) != Type::CLASS) {
 
-                                        if (it->second != exprListNode->getExprs()[i]->getType()) {
+                                        if (formalType != exprListNode->getExprs()[i]->getTypeId()) {
                                             error(exprListNode->getExprs()[i]->getFilename(), exprListNode->getExprs()[i]->getLine(), exprListNode->getExprs()[i]->getColumn(), "arg type not corresponding to definition of method");
                                         }
                                     } else {
@@ -1079,46 +952,101 @@ void FourthPass::visit(CallExprNode* node) {
                         if (methodIt != classMIt->second.end()) {
 
                             // set type
-                            const auto it = type_map_.find(methodIt->second);
-                            if (it != type_map_.end()) {
-                                node->setType(it->second);
-                                node->setTypename(it->first);
-                            } else {
-                                node->setType(Type::CLASS);
-                                node->setTypename(methodIt->second);
-                            }
+                            node->setTypeId(types_.intern(methodIt->second), types_);
                             break;
                         }
                     }
                 } 
             }
-            currentClass = classInfoMap_.at(currentClass).parentClassName;
+            currentClass = parentOf(currentClass);
         }
     }
 }
 
 void FourthPass::visit(IntegerLiteralNode* node) {
     
-    node->setType(Type::INT32);
-    node->setTypename("int32");
+    node->setTypeId(TypeTable::INT32);
 }
 
 void FourthPass::visit(LiteralNode* node) {
     
-    node->setType(Type::STRING);
-    node->setTypename("string");
+    node->setTypeId(TypeTable::STRING);
 }
 
 void FourthPass::visit(BooleanLiteralNode* node) {
     
-    node->setType(Type::BOOL);
-    node->setTypename("bool");
+    node->setTypeId(TypeTable::BOOL);
+}
+
+void FourthPass::depend(const std::string& className) {
+    if (dependencies_ != nullptr)
+        dependencies_->insert(className);
+}
+
+const std::string& FourthPass::parentOf(const std::string& className) {
+    depend(className);
+    return classInfoMap_.at(className).parentClassName;
 }
 
 bool FourthPass::isClassDefined(const std::string& className) {
+    depend(className);
     return classInfoMap_.find(className) != classInfoMap_.end();
 }
 
+void FourthPass::depend(TypeId type) {
+    if (dependencies_ != nullptr)
+        dependencies_->insert(types_.name(type));
+}
+
+TypeId FourthPass::parentOf(TypeId type) {
+    depend(type);
+    return type < parents_.size() ? parents_[type] : TypeTable::UNIT;
+}
+
+bool FourthPass::isClassDefined(TypeId type) {
+    depend(type);
+    return type == TypeTable::OBJECT || (type < parents_.size() && parents_[type] != TypeTable::UNIT);
+}
+
+// The type is the other one or one of its descendants
+bool FourthPass::conforms(TypeId type, TypeId other) {
+    while (type != other) {
+        if (!isClassDefined(type))
+            return false;
+        type = parentOf(type);
+    }
+    return true;
+}
+
+// First common ancestor of two classes, walking up from the same depth
+TypeId FourthPass::commonAncestor(TypeId first, TypeId second) {
+    std::size_t firstDepth = depthOf(first);
+    std::size_t secondDepth = depthOf(second);
+
+    for (; firstDepth > secondDepth; firstDepth--)
+        first = parentOf(first);
+    for (; secondDepth > firstDepth; secondDepth--)
+        second = parentOf(second);
+
+    while (first != second) {
+        if (!isClassDefined(first) || !isClassDefined(second))
+            return TypeTable::OBJECT;
+        first = parentOf(first);
+        second = parentOf(second);
+    }
+    return first;
+}
+
+// Number of classes between a class and Object
+std::size_t FourthPass::depthOf(TypeId type) {
+    std::size_t depth = 0;
+    while (type != TypeTable::OBJECT && isClassDefined(type)) {
+        type = parentOf(type);
+        depth++;
+    }
+    return depth;
+}
+
 bool FourthPass::isTypeDefined(const AST::Type& type) {
     switch(type) {
         case AST::Type::UNIT:
@@ -1136,7 +1064,7 @@ bool FourthPass::isMethodDefined(const std::string& className, const std::string
     std::string currentClass = className;
 
     // loop walks up class hierarchy
-    while (classInfoMap_.find(currentClass) != classInfoMap_.end()) {
+    while (isClassDefined(currentClass)) {
 
         // check if currentClass in classMethodTypes_
         if (classMethodTypes_.find(currentClass) != classMethodTypes_.end()) {
@@ -1146,7 +1074,7 @@ bool FourthPass::isMethodDefined(const std::string& className, const std::string
                 return true;
             } 
         }
-        currentClass = classInfoMap_.at(currentClass).parentClassName;
+        currentClass = parentOf(currentClass);
     }
     return false;
 }
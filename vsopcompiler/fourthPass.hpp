@@ -4,6 +4,7 @@
 #include <iostream>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "ast.hpp"
 #include "firstPass.hpp"
 
@@ -12,7 +13,12 @@ using namespace std;
 
 class FourthPass : public AST::Visitor {
     public:
-        FourthPass(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes);
+        FourthPass(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes, TypeTable& types);
+
+        // Check a field or a method alone, recording the classes whose
+        // declaration the check depends on
+        void checkField(AST::ClassNode* classNode, AST::FieldNode* node, std::unordered_set<std::string>& dependencies);
+        void checkMethod(AST::ClassNode* classNode, AST::MethodNode* node, std::unordered_set<std::string>& dependencies);
 
         void visit(AST::ProgramNode* node) override;
         void visit(AST::TypeNode* node) override;
@@ -66,20 +72,37 @@ class FourthPass : public AST::Visitor {
         const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>>
         classMethodFormalsTypes_;
 
-        static const std::unordered_map<std::string, Type> type_map_;
+        // Types of the expressions, owned by the compilation
+        TypeTable& types_;
+
+        // Parent of each class, indexed by type id
+        std::vector<TypeId> parents_;
 
+        void depend(const std::string& className);
+        const std::string& parentOf(const std::string& className);
         bool isClassDefined(const std::string& className);
+
+        void depend(TypeId type);
+        TypeId parentOf(TypeId type);
+        bool isClassDefined(TypeId type);
+        bool conforms(TypeId type, TypeId other);
+        TypeId commonAncestor(TypeId first, TypeId second);
+        std::size_t depthOf(TypeId type);
+
         bool isTypeDefined(const AST::Type& type);
         bool isMethodDefined(const std::string& className, const std::string& methodName);
         
         std::string currentClassName_;
+        TypeId currentClassId_;
         std::string currentMethodName_;
         // std::string currentFormalName_;
         std::string currentLetVar_;
-        AST::Type currentTypeLetVar_;
-        std::string currentLetTypename_;
+        TypeId currentLetType_;
         bool inField_;
 
+        // Classes the field or method being checked depends on, if recorded
+        std::unordered_set<std::string>* dependencies_;
+
 };
 
 #endif // FOURTH_PASS_HPP
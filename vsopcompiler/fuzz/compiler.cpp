@@ -0,0 +1,204 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "driver.hpp"
+#include "firstPass.hpp"
+#include "secondPass.hpp"
+#include "thirdPass.hpp"
+#include "fourthPass.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+/*
+    libFuzzer harness running the front end of the compiler in-process: the
+    lexer, the parser, the four semantic passes and evaluate(), as vsopc -c.
+
+    Besides the crashes, it aborts on the inputs taking too much time or
+    making too many allocations per byte, so that libFuzzer keeps them as
+    crashes: they show a super-linear phase. An input over the limits is run
+    again before aborting, since the time of a single run is noisy.
+
+    Usage: make fuzz, or fuzz/compiler [libFuzzer flags] <corpus directories>
+
+    Environment:
+      FUZZ_NS_PER_BYTE      maximum time per byte, in nanoseconds (default: 10000)
+      FUZZ_ALLOCS_PER_BYTE  maximum allocations per byte (default: 16)
+      FUZZ_SLACK            bytes added to the size of each input, for the
+                            cost of an empty program (default: 1024)
+*/
+
+extern bool checkMode;
+extern bool recoverableErrors;
+
+using namespace std;
+
+enum Phase {
+    LEX,
+    PARSE,
+    PASS1,
+    PASS2,
+    PASS3,
+    PASS4,
+    EVALUATE,
+    PHASES
+};
+
+static const char *phase_names[PHASES] = {
+    "lex", "parse", "pass1", "pass2", "pass3", "pass4", "evaluate"
+};
+
+// Time and allocations of each phase of a run.
+class Meter {
+    public:
+        Meter() : time(), allocations(), running(false) {}
+
+        void begin(Phase phase) {
+            end();
+
+            current = phase;
+            running = true;
+            startAllocations = Stats::allocations;
+            start = chrono::steady_clock::now();
+        }
+
+        void end() {
+            if (!running)
+                return;
+
+            time[current] += chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+            allocations[current] += Stats::allocations - startAllocations;
+            running = false;
+        }
+
+        double total_time() const {
+            double total = 0;
+            for (double t : time)
+                total += t;
+            return total;
+        }
+
+        size_t total_allocations() const {
+            size_t total = 0;
+            for (size_t n : allocations)
+                total += n;
+            return total;
+        }
+
+        double time[PHASES];
+        size_t allocations[PHASES];
+
+    private:
+        bool running;
+        Phase current;
+        size_t startAllocations;
+        chrono::steady_clock::time_point start;
+};
+
+static double max_ns_per_byte;
+static double max_allocs_per_byte;
+static double slack;
+
+static double env_limit(const char *name, double value) {
+    const char *text = getenv(name);
+    return text ? atof(text) : value;
+}
+
+// Discards the messages of the compiler.
+static struct NullBuffer : streambuf {
+    int overflow(int c) override { return c; }
+} null_buffer;
+
+static void run(const string &source, Meter &meter) {
+    VSOP::Driver driver("fuzz.vsop");
+    driver.set_source(source);
+
+    meter.begin(LEX);
+    if (driver.lex_source() != 0) {
+        meter.end();
+        return;
+    }
+
+    meter.begin(PARSE);
+    if (driver.parse() != 0) {
+        meter.end();
+        return;
+    }
+
+    AST::TypeTable types;
+    try {
+        meter.begin(PASS1);
+        FirstPass firstPass;
+        driver.res->accept(&firstPass);
+
+        meter.begin(PASS2);
+        SecondPass secondPass(firstPass.getClassInfoMap());
+        driver.res->accept(&secondPass);
+
+        meter.begin(PASS3);
+        ThirdPass thirdPass(firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes());
+        driver.res->accept(&thirdPass);
+
+        meter.begin(PASS4);
+        FourthPass fourthPass(firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes(), thirdPass.getClassMethodFormalTypes(), types);
+        driver.res->accept(&fourthPass);
+
+        meter.begin(EVALUATE);
+        driver.res->evaluate();
+    } catch (const SemanticError &) {
+        // Not reported, vsopc would have exited
+    }
+
+    meter.end();
+
+    for (auto &classNode : driver.res->getClasses())
+        delete classNode;
+    delete driver.res;
+}
+
+static bool over_limits(const Meter &meter, size_t size) {
+    double bytes = size + slack;
+
+    return meter.total_time() / bytes > max_ns_per_byte
+        || meter.total_allocations() / bytes > max_allocs_per_byte;
+}
+
+extern "C" int LLVMFuzzerInitialize(int *, char ***) {
+    max_ns_per_byte = env_limit("FUZZ_NS_PER_BYTE", 10000);
+    max_allocs_per_byte = env_limit("FUZZ_ALLOCS_PER_BYTE", 16);
+    slack = env_limit("FUZZ_SLACK", 1024);
+
+    // As the daemon: the semantic errors throw instead of exiting
+    checkMode = true;
+    recoverableErrors = true;
+
+    cerr.rdbuf(&null_buffer);
+
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    string source(reinterpret_cast<const char *>(data), size);
+
+    Meter meter;
+    run(source, meter);
+    if (!over_limits(meter, size))
+        return 0;
+
+    Meter again;
+    run(source, again);
+    if (!over_limits(again, size))
+        return 0;
+
+    fprintf(stderr, "super-linear input of %zu bytes: %.0f ns and %.1f allocations per byte\n",
+            size, again.total_time() / (size + slack), again.total_allocations() / (size + slack));
+    fprintf(stderr, "%-10s %12s %12s\n", "phase", "time (ms)", "allocations");
+    for (int phase = 0; phase < PHASES; phase++)
+        fprintf(stderr, "%-10s %12.3f %12zu\n", phase_names[phase], again.time[phase] / 1e6, again.allocations[phase]);
+
+    abort();
+}
@@ -0,0 +1,132 @@
+#ifndef _KEYWORDS_HPP
+#define _KEYWORDS_HPP
+
+#include <cstddef>
+#include <cstring>
+
+#include "parser.hpp"
+
+namespace VSOP {
+    namespace keywords {
+        /**
+         * @brief A keyword and its token.
+         */
+        struct Keyword {
+            const char *name;
+            Parser::token_type token;
+        };
+
+        constexpr Keyword list[] = {
+            {"and", Parser::token::AND},
+            {"bool", Parser::token::BOOL},
+            {"class", Parser::token::CLASS},
+            {"do", Parser::token::DO},
+            {"else", Parser::token::ELSE},
+            {"extends", Parser::token::EXTENDS},
+            {"false", Parser::token::FALSE},
+            {"if", Parser::token::IF},
+            {"in", Parser::token::IN},
+            {"int32", Parser::token::INT32},
+            {"isnull", Parser::token::ISNULL},
+            {"let", Parser::token::LET},
+            {"new", Parser::token::NEW},
+            {"not", Parser::token::NOT},
+            {"self", Parser::token::SELF},
+            {"string", Parser::token::STRING},
+            {"then", Parser::token::THEN},
+            {"true", Parser::token::TRUE},
+            {"unit", Parser::token::UNIT},
+            {"while", Parser::token::WHILE},
+        };
+
+        constexpr std::size_t count = sizeof(list) / sizeof(list[0]);
+
+        /**
+         * @brief Number of slots of the hash table.
+         */
+        constexpr std::size_t size = 32;
+
+        /**
+         * @brief Hash of an identifier, perfect on the keywords.
+         *
+         * The coefficients were found by an exhaustive search over the
+         * keywords, is_perfect() checks them at compile time.
+         *
+         * @param s The identifier.
+         * @param length The length of the identifier, at least 1.
+         */
+        constexpr std::size_t hash(const char *s, std::size_t length) {
+            return (4 * static_cast<unsigned char>(s[0])
+                    + 15 * static_cast<unsigned char>(s[length - 1])
+                    + 6 * length) % size;
+        }
+
+        constexpr std::size_t length(const char *s) {
+            std::size_t n = 0;
+            while (s[n] != '\0')
+                ++n;
+            return n;
+        }
+
+        /**
+         * @brief Hash table of the keywords, -1 for an empty slot.
+         */
+        struct Table {
+            int index[size];
+            std::size_t length[size];
+        };
+
+        constexpr Table make_table() {
+            Table table = {};
+
+            for (std::size_t i = 0; i < size; ++i)
+                table.index[i] = -1;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t n = length(list[i].name);
+                std::size_t slot = hash(list[i].name, n);
+
+                table.index[slot] = static_cast<int>(i);
+                table.length[slot] = n;
+            }
+
+            return table;
+        }
+
+        constexpr Table table = make_table();
+
+        // Each keyword is in its own slot, none was overwritten by another.
+        constexpr bool is_perfect() {
+            for (std::size_t i = 0; i < count; ++i) {
+                if (table.index[hash(list[i].name, length(list[i].name))] != static_cast<int>(i))
+                    return false;
+            }
+
+            return true;
+        }
+
+        static_assert(is_perfect(), "the keyword hash has collisions");
+
+        /**
+         * @brief Get the token of an object identifier.
+         *
+         * @param s The identifier.
+         * @param length The length of the identifier, at least 1.
+         *
+         * @return Parser::token_type The token of the keyword, or
+         * OBJECT_IDENTIFIER if the identifier is not a keyword.
+         */
+        inline Parser::token_type lookup(const char *s, std::size_t length) {
+            std::size_t slot = hash(s, length);
+            int index = table.index[slot];
+
+            if (index >= 0 && table.length[slot] == length
+                && std::memcmp(list[index].name, s, length) == 0)
+                return list[index].token;
+
+            return Parser::token::OBJECT_IDENTIFIER;
+        }
+    }
+}
+
+#endif
@@ -1,5 +1,8 @@
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "driver.hpp" // /!\ here error with parser.hpp not being present anymore
 #include "ast.hpp"
@@ -7,7 +10,14 @@
 #include "secondPass.hpp"
 #include "thirdPass.hpp"
 #include "fourthPass.hpp"
+#include "fifthPass.hpp"
+#include "flatAst.hpp"
+#include "sixthPass.hpp"
 #include "codeGeneration.hpp"
+#include "xref.hpp"
+#include "stats.hpp"
+#include "daemon.hpp"
+#include "server.hpp"
 
 using namespace std;
 
@@ -27,51 +37,154 @@ static const map<string, Mode> flag_to_mode = {
 };
 
 extern bool checkMode;
+extern bool recoverableErrors;
 bool llvmMode;
 
-int main(int argc, char const *argv[]) {
+static const char *program;
+
+static const map<string, VSOP::ParserKind> flag_to_parser = {
+    {"--parser=bison", VSOP::ParserKind::BISON},
+    {"--parser=fast", VSOP::ParserKind::FAST}
+};
+
+// Parse with both parsers, and check that they give the same AST and the
+// same first syntax error, the fast parser does not recover from it. The
+// AST and the errors of bison are kept.
+static int compare_parsers(VSOP::Driver &driver) {
+    const VSOP::ParserKind kinds[2] = {VSOP::ParserKind::FAST, VSOP::ParserKind::BISON};
+    const char *names[2] = {"fast", "bison"};
+    int results[2];
+    string outputs[2];
+    string errors[2];
+
+    // The ASTs are printed before the semantic analysis
+    bool check = checkMode;
+    checkMode = false;
+
+    for (int i = 0; i < 2; i++) {
+        ostringstream messages;
+        driver.set_errors(messages);
+
+        driver.set_parser(kinds[i]);
+        results[i] = driver.parse();
+        if (results[i] == 0)
+            outputs[i] = driver.res->evaluate();
+
+        // Only the AST of bison is kept
+        if (i == 0 && driver.res != nullptr) {
+            for (auto &classNode : driver.res->getClasses())
+                delete classNode;
+            delete driver.res;
+            driver.res = nullptr;
+        }
+
+        errors[i] = messages.str();
+    }
+    driver.set_errors(cerr);
+
+    checkMode = check;
+
+    cerr << errors[1];
+
+    string first_error = errors[1].substr(0, errors[1].find('\n') + 1);
+    if (results[0] != results[1] || outputs[0] != outputs[1] || errors[0] != first_error) {
+        cerr << program << ": the " << names[0] << " and " << names[1] << " parsers differ" << endl;
+        for (int i = 0; i < 2; i++)
+            cerr << names[i] << ": " << (results[i] == 0 ? outputs[i] : errors[i]) << endl;
+        return 1;
+    }
+
+    return results[1];
+}
+
+static int compile(const vector<string> &arguments) {
     Mode mode;
     string source_file;
 
-    if (argc == 2) {
+    // Choose the parser, with any mode
+    VSOP::ParserKind parser = VSOP::ParserKind::BISON;
+    bool compare = false;
+    bool xref = false;
+    bool fold = false;
+    vector<string> args;
+    for (const string &arg : arguments) {
+        if (flag_to_parser.count(arg))
+            parser = flag_to_parser.at(arg);
+        else if (arg == "--parser=check")
+            compare = true;
+        else if (arg == "--xref")
+            xref = true;
+        else if (arg == "--fold")
+            fold = true;
+        else
+            args.push_back(arg);
+    }
+
+    if (args.size() == 1) {
         mode = Mode::PARSER; //TODO change standard mode
-        source_file = argv[1];
+        source_file = args[0];
     }
-    else if (argc == 3) {
-        if (flag_to_mode.count(argv[1]) == 0) {
-            cerr << "Invalid mode: " << argv[1] << endl;
+    else if (args.size() == 2) {
+        if (flag_to_mode.count(args[0]) == 0) {
+            cerr << "Invalid mode: " << args[0] << endl;
             return -1;
         }
-        mode = flag_to_mode.at(argv[1]);
-        if (std::string(argv[1]).compare("-i") == 0) {
+        mode = flag_to_mode.at(args[0]);
+        if (args[0].compare("-i") == 0) {
             llvmMode = true;
         } else {
             llvmMode = false;
         }
-        source_file = argv[2];
+        source_file = args[1];
     }
     else {
-        cerr << "Usage: " << argv[0] << " [-l|-p|-c|-i] <source_file>" << endl;
+        cerr << "Usage: " << program << " [--stats[=json]|-ftime-report] [--parser=bison|fast|check] [--xref] [--fold] [-l|-p|-c|-i] <source_file>" << endl
+             << "       " << program << " --query <index_file> def|refs <class> [<member>]" << endl
+             << "       " << program << " --daemon" << endl
+             << "       " << program << " --server <socket>" << endl;
+        return -1;
+    }
+
+    // A server runs several commands
+    checkMode = false;
+
+    // The index is written from the checked program
+    if (xref && mode != Mode::CHECKER) {
+        cerr << "Invalid mode with --xref: " << (args.size() == 2 ? args[0] : "-p") << ", expected -c or -i" << endl;
+        return -1;
+    }
+
+    // --fold prints the checked AST after FifthPass, to observe the folding
+    if (fold && (mode != Mode::CHECKER || llvmMode)) {
+        cerr << "Invalid mode with --fold: " << (args.size() == 2 ? args[0] : "-p") << ", expected -c" << endl;
         return -1;
     }
 
     VSOP::Driver driver = VSOP::Driver(source_file);
+    driver.set_parser(parser);
 
     int res;
     switch (mode) {
         case Mode::LEXER:
+            stats.begin("lex");
             res = driver.lex();
+            stats.count("tokens", driver.get_token_count());
+            stats.end();
 
             driver.print_tokens();
 
             return res;
 
         case Mode::PARSER:
+            stats.begin("lex");
             res = driver.lex();
+            stats.count("tokens", driver.get_token_count());
             if (res != 0) {return res;}
 
             // Parse the source code and generate the AST
-            res = driver.parse();
+            stats.begin("parse");
+            res = compare ? compare_parsers(driver) : driver.parse();
+            stats.end();
 
             if (res == 0)
                 cout << driver.res->evaluate() << endl;
@@ -81,39 +194,164 @@ int main(int argc, char const *argv[]) {
         case Mode::CHECKER:
             checkMode = true; // use in evaluate() to print type
 
+            stats.begin("lex");
             res = driver.lex();
+            stats.count("tokens", driver.get_token_count());
             if (res != 0) {return res;}
 
             // Parse the source code and generate the AST
-            res = driver.parse();
+            stats.begin("parse");
+            res = compare ? compare_parsers(driver) : driver.parse();
             if (res != 0) {return res;}
 
+            // The types of this program only, a server compiles many
+            AST::TypeTable types;
+
+            stats.begin("pass1");
             FirstPass firstPass;
             driver.res->accept(&firstPass);
 
+            stats.begin("pass2");
             SecondPass secondPass(firstPass.getClassInfoMap());
             driver.res->accept(&secondPass);
 
+            stats.begin("pass3");
             ThirdPass thirdPass(firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes());
             driver.res->accept(&thirdPass);
 
-            FourthPass fourthPass(firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes(), thirdPass.getClassMethodFormalTypes());
+            stats.begin("pass4");
+            FourthPass fourthPass(firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes(), thirdPass.getClassMethodFormalTypes(), types);
             driver.res->accept(&fourthPass);
 
-            if (!llvmMode){
+            // The index of the checked program, next to the source file
+            if (xref) {
+                stats.begin("xref");
+                // Only the extension of the file name is replaced, not a dot in a directory
+                size_t name = source_file.find_last_of('/') + 1;
+                size_t extension = source_file.find_last_of('.');
+                if (extension == string::npos || extension <= name)
+                    extension = source_file.size();
+                string index_file = source_file.substr(0, extension) + ".xref";
+                if (!VSOP::Xref::write(index_file, driver.res, firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes()))
+                    return 1;
+            }
+            stats.end();
+
+            if (fold) {
+                stats.begin("optimize");
+                FifthPass fifthPass;
+                driver.res->accept(&fifthPass);
+                stats.end();
+
+                cout << AST::FlatAst(driver.res, true).evaluate() << endl;
+            } else if (!llvmMode){
                 if (res == 0) {
                     cout << driver.res->evaluate() << endl;
                 }
             } else { //LLVM Mode
-            
+
+                stats.begin("optimize");
+                FifthPass fifthPass;
+                driver.res->accept(&fifthPass);
+
+                // Only the classes and methods reachable from Main.main are generated
+                stats.begin("prune");
+                SixthPass sixthPass(firstPass.getClassInfoMap(), secondPass.getClassMethodTypes(), secondPass.getClassFieldTypes(), thirdPass.getClassMethodFormalTypes(), firstPass.getClassOrder());
+                driver.res->accept(&sixthPass);
+
+                // The emit and link phases are started by the code generation
+                stats.begin("ir");
                 CodeGeneration codeGeneration(
-                    firstPass.getClassInfoMap(),
-                    secondPass.getClassMethodTypes(),
-                    secondPass.getClassFieldTypes(),
-                    thirdPass.getClassMethodFormalTypes());
+                    sixthPass.getClassInfoMap(),
+                    sixthPass.getClassMethodTypes(),
+                    sixthPass.getClassFieldTypes(),
+                    sixthPass.getClassMethodFormalTypes(),
+                    sixthPass.getClassOrder());
                 driver.res->accept(&codeGeneration);
+                stats.end();
             }
             return res;
     }
     return 0;
 }
+
+// Print the definitions of, or the references to, the class or member given
+static int query(const vector<string> &args) {
+    const string &kind = args[2];
+    if (kind != "def" && kind != "refs") {
+        cerr << "Invalid query: " << kind << endl;
+        return -1;
+    }
+
+    VSOP::Xref xref;
+    if (!xref.open(args[1]))
+        return 1;
+
+    string member = args.size() == 5 ? args[4] : "";
+    size_t found = kind == "def" ? xref.definitions(args[3], member, cout) : xref.references(args[3], member, cout);
+    if (found == 0) {
+        cerr << "No symbol " << args[3] << (member.empty() ? "" : "." + member) << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char const *argv[]) {
+    program = argv[0];
+
+    // Remove the statistics flags, they can be given with any mode
+    vector<string> args;
+    bool statistics = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+
+        if (arg == "--stats" || arg == "-ftime-report")
+            stats.enable(false);
+        else if (arg == "--stats=json")
+            stats.enable(true);
+        else {
+            args.push_back(arg);
+            continue;
+        }
+
+        statistics = true;
+    }
+
+    // Answer from the index written by --xref, without checking the file
+    if ((args.size() == 4 || args.size() == 5) && args[0] == "--query")
+        return query(args);
+
+    // Keep the files in memory and check them on request
+    if (args.size() == 1 && args[0] == "--daemon") {
+        checkMode = true;
+        recoverableErrors = true;
+        llvmMode = false;
+
+        VSOP::Daemon daemon;
+        return daemon.run(cin, cout);
+    }
+
+    // Compile on requests, the runtime is only compiled once
+    if (args.size() == 2 && args[0] == "--server") {
+        recoverableErrors = true;
+        CodeGeneration::prebuildRuntime();
+
+        VSOP::Server server(args[1], compile);
+        int res = server.run();
+
+        CodeGeneration::removeRuntime();
+
+        return res;
+    }
+
+    // Let the server given by VSOPC_SERVER compile, if any. The statistics
+    // and the standard input are those of this process.
+    const char *server = getenv("VSOPC_SERVER");
+    int res;
+    if (server && !statistics && !args.empty() && args.back() != "-"
+        && VSOP::Server::forward(server, args, res))
+        return res;
+
+    return compile(args);
+}
@@ -29,28 +29,56 @@
 // C++ code put inside header file
 %code requires {
     #include <string>
+    #include <vector>
     #include "ast.hpp"
 
     namespace VSOP
     {
         class Driver;
+
+        // The fields and methods of a class body
+        struct Members {
+            std::vector<AST::FieldNode*> fields;
+            std::vector<AST::MethodNode*> methods;
+        };
     }
 }
 
 // Add an argument to the parser constructor
 %parse-param {VSOP::Driver &driver}
 
+// The parser reads its tokens from the driver
+%lex-param {VSOP::Driver &driver}
+
 %code {
+    #include <algorithm>
     #include "driver.hpp"
 
     using namespace std;
 
-    vector<AST::ClassNode*> classes;
-    vector<AST::FieldNode*> fields;
-    vector<AST::MethodNode*> methods;
-    vector<AST::FormalNode*> formals;
-    vector<AST::ExprNode*> blocks;
-    vector<AST::ExprNode*> exprs;
+    namespace VSOP {
+        // Give the tokens stored by Driver::lex() to the parser.
+        static Parser::symbol_type yylex(Driver &driver) {
+            return driver.next_token();
+        }
+
+        // The lists are built in source order, the nodes take them from
+        // their last element
+        template <typename T>
+        static vector<T> reversed(vector<T> list) {
+            std::reverse(list.begin(), list.end());
+            return list;
+        }
+
+        // Give the node of a symbol to the action, it is not deleted with
+        // the symbol
+        template <typename T>
+        static T *take(T *&node) {
+            T *taken = node;
+            node = nullptr;
+            return taken;
+        }
+    }
 }
 
 // Token and symbols definitions
@@ -129,29 +157,62 @@
 %type<AST::BlockNode*> block
 %type<AST::ExprNode*> expr
 %type<AST::ArgsNode*> args
+
+%type<std::vector<AST::ClassNode*>> class-list
+%type<VSOP::Members> members
+%type<std::vector<AST::FormalNode*>> formal-list
+%type<std::vector<AST::ExprNode*>> expr-list
+%type<std::vector<AST::ExprNode*>> arg-list
+
+// The nodes of a symbol are deleted with it unless an action takes them,
+// the symbols discarded by the error recovery do not leak
+%destructor { delete $$; } <AST::ClassNode*> <AST::ClassBodyNode*> <AST::FieldNode*> <AST::MethodNode*>
+%destructor { delete $$; } <AST::TypeNode*> <AST::FormalsNode*> <AST::FormalNode*> <AST::BlockNode*>
+%destructor { delete $$; } <AST::ExprNode*> <AST::ArgsNode*>
+%destructor {
+    for (auto node : $$)
+        delete node;
+} <std::vector<AST::ClassNode*>> <std::vector<AST::FormalNode*>> <std::vector<AST::ExprNode*>>
+%destructor {
+    for (auto field : $$.fields)
+        delete field;
+    for (auto method : $$.methods)
+        delete method;
+} <VSOP::Members>
 %%
 // Grammar rules
 
+// After a syntax error, the parser skips the tokens up to the end of
+// the expression of a block, of the member or of the class, and goes on
+// to report the following errors. The rules reporting an error give no
+// node, the AST is only used if there is no error.
+
 %start program;
 program:
-    class-rec                   {
+    class-list                  {
                                     std::string filename = *(@1.begin.filename);
-                                    driver.res = new AST::ProgramNode(classes, filename, @1.begin.line, @1.begin.column);
-                                    classes.clear();
+                                    driver.res = new AST::ProgramNode(reversed(std::move($1)), filename, @1.begin.line, @1.begin.column);
                                 };
-class-rec:
+class-list:
     class                       {
-                                    classes.push_back($1);
+                                    $$.push_back(take($1));
+                                };
+    | class-list class          {
+                                    $$ = std::move($1);
+                                    $$.push_back(take($2));
                                 };
-    | class class-rec           {
-                                    classes.push_back($1);
+    | error                     {
+                                    $$ = {};
+                                };
+    | class-list error          {
+                                    $$ = std::move($1);
                                 };
 class:
     "class" TYPE_IDENTIFIER class-body                                  {
                                                                             std::string* str = new std::string($2);
                                                                             std::string* str2 = new std::string("");
                                                                             std::string filename = *(@1.begin.filename);
-                                                                            $$ = new AST::ClassNode(str, str2, $3, filename, @1.begin.line, @1.begin.column);
+                                                                            $$ = new AST::ClassNode(str, str2, take($3), filename, @1.begin.line, @1.begin.column);
                                                                             delete str;
                                                                             delete str2;
                                                                         };
@@ -159,62 +220,75 @@ class:
                                                                             std::string* str1 = new std::string($2);
                                                                             std::string* str2 = new std::string($4);
                                                                             std::string filename = *(@1.begin.filename);
-                                                                            $$ = new AST::ClassNode(str1, str2, $5, filename, @1.begin.line, @1.begin.column);
+                                                                            $$ = new AST::ClassNode(str1, str2, take($5), filename, @1.begin.line, @1.begin.column);
                                                                             delete str1;
                                                                             delete str2;
                                                                         };
 class-body:
-    LBRACE field-method RBRACE  {
-                                    $$ = new AST::ClassBodyNode(fields, methods);
-                                    fields.clear();
-                                    methods.clear();
+    LBRACE members RBRACE       {
+                                    $$ = new AST::ClassBodyNode(reversed(std::move($2.fields)), reversed(std::move($2.methods)));
                                 };
-field-method:
+members:
     %empty                      {
-                                    
+                                    $$ = {};
+                                };
+    | members field             {
+                                    $$ = std::move($1);
+                                    $$.fields.push_back(take($2));
                                 };
-    | field field-method        {
-                                    fields.push_back($1);
+    | members method            {
+                                    $$ = std::move($1);
+                                    $$.methods.push_back(take($2));
                                 };
-    | method field-method       {
-                                    methods.push_back($1);
+    | members error SEMICOLON   {
+                                    $$ = std::move($1);
+                                };
+    | members error block       {
+                                    $$ = std::move($1);
+                                    delete take($3);
                                 };
 field:
     TYPE_IDENTIFIER COLON type SEMICOLON                       {
                                                                     error(@1, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($3);
+                                                                    $$ = nullptr;
                                                                };
     | OBJECT_IDENTIFIER COLON type SEMICOLON                   {    
                                                                     std::string* str = new std::string($1);
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::FieldNode(str, $3, NULL, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::FieldNode(str, take($3), NULL, filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                };
     | TYPE_IDENTIFIER COLON type ASSIGN expr SEMICOLON         {
                                                                     error(@1, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($3);
+                                                                    delete take($5);
+                                                                    $$ = nullptr;
                                                                };
     | OBJECT_IDENTIFIER COLON type ASSIGN expr SEMICOLON       {    
                                                                     std::string* str = new std::string($1);
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::FieldNode(str, $3, $5, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::FieldNode(str, take($3), take($5), filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                };
 method:
     TYPE_IDENTIFIER LPAR formals RPAR COLON type block         {
                                                                     error(@1, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($3);
+                                                                    delete take($6);
+                                                                    delete take($7);
+                                                                    $$ = nullptr;
                                                                };
     | OBJECT_IDENTIFIER LPAR formals RPAR COLON type block     {    
                                                                     std::string* str = new std::string($1);
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::MethodNode(str, $3, $6, $7, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::MethodNode(str, take($3), take($6), take($7), filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                };
 type:
     OBJECT_IDENTIFIER           {
                                     error(@1, "expected a type-identifier but object-identifier was given");
-                                    YYERROR;
+                                    $$ = nullptr;
                                 };
     | TYPE_IDENTIFIER           {
                                     std::string* str = new std::string($1);
@@ -246,168 +320,170 @@ type:
                                     $$ = new AST::TypeNode(str, filename, @1.begin.line, @1.begin.column);
                                     delete str;
                                 };
-    | error                     {
-                                    error(@1, "unexpected type");
-                                    YYERROR;
-                                };
 formals:
     %empty                      {
-                                    $$ = new AST::FormalsNode(formals);
-                                    formals.clear();
-                                    
+                                    $$ = new AST::FormalsNode({});
                                 };
-    | formal                    {
-                                    formals.push_back($1);
-                                    $$ = new AST::FormalsNode(formals);
-                                    formals.clear();
+    | formal-list               {
+                                    $$ = new AST::FormalsNode(reversed(std::move($1)));
                                 };
-    | formal formals-rec        {
-                                    formals.push_back($1);
-                                    $$ = new AST::FormalsNode(formals);
-                                    formals.clear();
-                                };
-formals-rec:
-    COMMA formal                                                {
-                                                                    formals.push_back($2);
+formal-list:
+    formal                                                      {
+                                                                    $$.push_back(take($1));
                                                                 };
-    | COMMA formal formals-rec                                  {
-                                                                    formals.push_back($2);
+    | formal-list COMMA formal                                  {
+                                                                    $$ = std::move($1);
+                                                                    $$.push_back(take($3));
                                                                 };
 formal: OBJECT_IDENTIFIER COLON type                            {
                                                                     std::string* str = new std::string($1);
-                                                                    $$ = new AST::FormalNode(str, $3);
+                                                                    $$ = new AST::FormalNode(str, take($3));
                                                                     delete str;
                                                                 };
 block:
-
-    LBRACE expr block-rec RBRACE                              {
-                                                                    blocks.push_back($2);
-                                                                    $$ = new AST::BlockNode(blocks);
-                                                                    blocks.clear();
+    LBRACE expr-list RBRACE                                     {
+                                                                    $$ = new AST::BlockNode(reversed(std::move($2)));
                                                                 };
-block-rec:
-    %empty                      {
-                                    
+expr-list:
+    expr                        {
+                                    $$.push_back(take($1));
                                 };
-    | SEMICOLON expr block-rec  {
-                                    blocks.push_back($2);
+    | expr-list SEMICOLON expr  {
+                                    $$ = std::move($1);
+                                    $$.push_back(take($3));
+                                };
+    | error                     {
+                                    $$ = {};
+                                };
+    | expr-list SEMICOLON error {
+                                    $$ = std::move($1);
                                 };
 expr:
     "if" expr "then" expr %prec LOWER_THAN_ELSE                 {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::IfThenElseExprNode($2, $4, NULL, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::IfThenElseExprNode(take($2), take($4), NULL, filename, @1.begin.line, @1.begin.column);
                                                                 };
     /* | "if" expr "then" expr SEMICOLON "else" expr               {
                                                                     error(@5, "unexpected semicolon");
-                                                                    YYERROR;
                                                                 }; */
     | "if" expr "then" expr "else" expr                         {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::IfThenElseExprNode($2, $4, $6, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::IfThenElseExprNode(take($2), take($4), take($6), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | "while" expr SEMICOLON "do" expr                          {
                                                                     error(@3, "unexpected semicolon");
-                                                                    YYERROR;
+                                                                    delete take($2);
+                                                                    delete take($5);
+                                                                    $$ = nullptr;
                                                                 };                                                                
     | "while" expr "do" expr                                    {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::WhileDoExprNode($2, $4, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::WhileDoExprNode(take($2), take($4), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | "let" TYPE_IDENTIFIER COLON type "in" expr                {
                                                                     error(@2, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($4);
+                                                                    delete take($6);
+                                                                    $$ = nullptr;
                                                                 };
     | "let" TYPE_IDENTIFIER COLON type ASSIGN expr "in" expr    {
                                                                     error(@2, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($4);
+                                                                    delete take($6);
+                                                                    delete take($8);
+                                                                    $$ = nullptr;
                                                                 };                                                            
     | "let" OBJECT_IDENTIFIER COLON type "in" expr              {
                                                                     std::string* str = new std::string($2);
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::LetExprNode(str, $4, NULL, $6, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::LetExprNode(str, take($4), NULL, take($6), filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                 };
     | "let" OBJECT_IDENTIFIER COLON type ASSIGN expr "in" expr  {
                                                                     std::string* str = new std::string($2);
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::LetExprNode(str, $4, $6, $8, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::LetExprNode(str, take($4), take($6), take($8), filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                 };
     | TYPE_IDENTIFIER ASSIGN expr                               {
                                                                     error(@1, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($3);
+                                                                    $$ = nullptr;
                                                                 };
     | OBJECT_IDENTIFIER ASSIGN expr                             {
                                                                     std::string* str = new std::string($1);
                                                                     std::string filename = *(@1.begin.filename);
                                                                     AST::VariableExprNode* variable = new AST::VariableExprNode(str, filename, @1.begin.line, @1.begin.column);
                                                                     std::string* str2 = new std::string($1);
-                                                                    $$ = new AST::AssignExprNode(str2, variable, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::AssignExprNode(str2, variable, take($3), filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                     delete str2;
                                                                 };
     | "not" expr                                                {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::NotNode($2, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::NotNode(take($2), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr "and" expr                                           {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::AndNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::AndNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr EQUAL expr                                           {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::EqualNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::EqualNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr LOWER expr                                           {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::LowerNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::LowerNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr LOWER_EQUAL expr                                     {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::LowerEqualNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::LowerEqualNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr PLUS expr                                            {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::PlusNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::PlusNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr MINUS expr                                           {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::MinusNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::MinusNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr TIMES expr                                           {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::TimesNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::TimesNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr DIV expr                                             {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::DivNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::DivNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | expr POW expr                                             {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::PowNode($1, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::PowNode(take($1), take($3), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | MINUS expr %prec UMINUS                                   {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::UnaryMinusNode($2, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::UnaryMinusNode(take($2), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | "isnull" expr                                             {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::IsNullNode($2, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::IsNullNode(take($2), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | TYPE_IDENTIFIER LPAR args RPAR                            {
                                                                     error(@1, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($3);
+                                                                    $$ = nullptr;
                                                                 };
     | expr DOT TYPE_IDENTIFIER LPAR args RPAR                   {
                                                                     error(@3, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    delete take($1);
+                                                                    delete take($5);
+                                                                    $$ = nullptr;
                                                                 };                                                            
     | OBJECT_IDENTIFIER LPAR args RPAR                          {
                                                                     std::string* str = new std::string($1);
                                                                     std::string* self = new std::string("self");
                                                                     std::string filename = *(@1.begin.filename);
                                                                     AST::ExprNode* objExpr = new AST::VariableExprNode(self, filename, @1.begin.line, @1.begin.column);
-                                                                    $$ = new AST::CallExprNode(objExpr, str, $3, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::CallExprNode(objExpr, str, take($3), filename, @1.begin.line, @1.begin.column);
                                                                     delete self;
                                                                     delete str;
 
@@ -415,12 +491,12 @@ expr:
     | expr DOT OBJECT_IDENTIFIER LPAR args RPAR                 {
                                                                     std::string* str = new std::string($3);
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::CallExprNode($1, str, $5, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::CallExprNode(take($1), str, take($5), filename, @1.begin.line, @1.begin.column);
                                                                     delete str;
                                                                 };
     | "new" OBJECT_IDENTIFIER                                   {
                                                                     error(@2, "expected a type-identifier but object-identifier was given");
-                                                                    YYERROR;
+                                                                    $$ = nullptr;
                                                                 };
     | "new" TYPE_IDENTIFIER                                     {
                                                                     std::string* str = new std::string($2);
@@ -430,7 +506,7 @@ expr:
                                                                 };
     | TYPE_IDENTIFIER                                           {
                                                                     error(@1, "expected an object-identifier but type-identifier was given");
-                                                                    YYERROR;
+                                                                    $$ = nullptr;
                                                                 };
     | OBJECT_IDENTIFIER                                         {
                                                                     std::string* str = new std::string($1);
@@ -470,45 +546,38 @@ expr:
                                                                 };
     | LPAR expr RPAR                                            {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::ParExprNode($2, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::ParExprNode(take($2), filename, @1.begin.line, @1.begin.column);
                                                                 };
     | block                                                     {
                                                                     std::string filename = *(@1.begin.filename);
-                                                                    $$ = new AST::BlockExprNode($1, filename, @1.begin.line, @1.begin.column);
+                                                                    $$ = new AST::BlockExprNode(take($1), filename, @1.begin.line, @1.begin.column);
                                                                 };
 args:
     %empty                      {
-                                    $$ = new AST::ArgsNode(exprs);
-                                    exprs.clear();
+                                    $$ = new AST::ArgsNode({});
                                 };
-    | expr                      {
-                                    exprs.push_back($1);
-                                    $$ = new AST::ArgsNode(exprs);
-                                    exprs.clear();
+    | arg-list                  {
+                                    $$ = new AST::ArgsNode(reversed(std::move($1)));
                                 };
-    | expr args-rec             {
-                                    exprs.push_back($1);
-                                    $$ = new AST::ArgsNode(exprs);
-                                    exprs.clear();
+arg-list:
+    expr                        {
+                                    $$.push_back(take($1));
                                 };
-args-rec:
-    COMMA expr                  {
-                                    exprs.push_back($2);
-                                };
-    | COMMA expr args-rec       {
-                                    exprs.push_back($2);
+    | arg-list COMMA expr       {
+                                    $$ = std::move($1);
+                                    $$.push_back(take($3));
                                 };
 %%
 // User code
 void VSOP::Parser::error(const location_type& l, const std::string& m) {
     const position &pos = l.begin;
 
-    cerr << *(pos.filename) << ":"
+    driver.get_errors() << *(pos.filename) << ":"
          << pos.line << ":" 
          << pos.column << ": "
          << " syntax error: "
          << m
          << endl;
 
-    exit(1);
-}
\ No newline at end of file
+    driver.syntax_errors++;
+}
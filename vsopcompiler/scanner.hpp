@@ -0,0 +1,104 @@
+#ifndef _SCANNER_HPP
+#define _SCANNER_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+// State of a reentrant flex scanner, as declared by flex.
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+// Give prototype of yylex() function, then declare it.
+#define YY_DECL VSOP::Parser::symbol_type yylex(yyscan_t yyscanner)
+YY_DECL;
+
+namespace VSOP {
+    /**
+     * @brief A lexical error, printed once the scan is over.
+     */
+    struct LexicalError {
+        position pos;
+        std::string message;
+    };
+
+    /**
+     * @brief A run of the lexer on a range of the source code.
+     *
+     * The scanners do not share any state, several of them can run at the
+     * same time on different threads.
+     */
+    class Scanner {
+        public:
+            /**
+             * @brief Start the lexer.
+             *
+             * @param source The source code.
+             * @param begin The offset of the first character scanned.
+             * @param end The offset following the last character scanned.
+             * @param start The position of the first character scanned.
+             */
+            Scanner(const std::string &source, std::size_t begin, std::size_t end,
+                    const position &start);
+
+            Scanner(const Scanner &) = delete;
+            Scanner &operator=(const Scanner &) = delete;
+
+            /**
+             * @brief Stop the lexer.
+             */
+            ~Scanner();
+
+            /**
+             * @brief Read the next token, YYEOF at the end of the range.
+             */
+            Parser::symbol_type next();
+
+            /**
+             * @brief Print lexical errors.
+             *
+             * @param errors The errors.
+             * @param lines The number of lines added to their positions.
+             * @param out The stream of the errors.
+             */
+            static void print_errors(const std::vector<LexicalError> &errors, int lines, std::ostream &out);
+
+            /**
+             * @brief The offset in the source of the next character to match.
+             */
+            std::size_t scan_offset;
+
+            /**
+             * @brief The offset in the source of the first character of the
+             * last token.
+             */
+            std::size_t token_offset;
+
+            /**
+             * @brief The lexical errors found so far.
+             */
+            std::vector<LexicalError> errors;
+
+            // State of the lexer between two tokens
+            location loc;
+            location loc_string;
+            std::stack<location> loc_comment;
+            int comment_nesting;
+
+            /**
+             * @brief The value of the last string literal, its buffer is reused.
+             */
+            std::string string_content;
+
+        private:
+            yyscan_t flex_scanner;
+    };
+}
+
+#endif
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "server.hpp"
+#include "utils.hpp"
+
+using namespace std;
+using namespace VSOP;
+
+extern bool checkMode;
+
+/**
+ * @brief Open a socket to the given path.
+ *
+ * @return int The socket, or -1 if the path is too long.
+ */
+static int open_socket(const string &path, sockaddr_un &address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+static bool write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        // The peer can be gone, do not get killed by SIGPIPE
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        data += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Read until the peer closes its side of the connection.
+ */
+static bool read_all(int fd, string &data) {
+    char buffer[1 << 16];
+
+    while (true) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+        if (n == 0)
+            return true;
+
+        data.append(buffer, n);
+    }
+}
+
+Server::Server(const string &socket_path, Compile compile)
+: socket_path(socket_path), compile(std::move(compile)) {}
+
+static volatile sig_atomic_t stopping = 0;
+
+static void stop(int) {
+    stopping = 1;
+}
+
+/**
+ * @brief Set the handler of SIGINT and SIGTERM, without restarting the
+ * interrupted calls.
+ */
+static void handle_signals(void (*handler)(int)) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+/**
+ * @brief Write the answer of a request.
+ */
+static void answer(int connection, int res, const string &out, const string &err) {
+    string answer = to_string(res) + " " + to_string(out.size()) + " " + to_string(err.size()) + "\n"
+                  + out + err;
+
+    write_all(connection, answer.data(), answer.size());
+}
+
+int Server::run() {
+    sockaddr_un address;
+    int listener = open_socket(socket_path, address);
+
+    if (listener < 0) {
+        cerr << "cannot listen on " << socket_path << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+
+    // A socket left by a server which stopped can be replaced, not the
+    // one of a running server
+    if (connect(listener, (sockaddr *) &address, sizeof(address)) == 0) {
+        cerr << "cannot listen on " << socket_path << ": a server is already running\n";
+        close(listener);
+        return 1;
+    }
+
+    close(listener);
+    listener = open_socket(socket_path, address);
+    unlink(socket_path.c_str());
+
+    if (bind(listener, (sockaddr *) &address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        cerr << "cannot listen on " << socket_path << ": " << strerror(errno) << '\n';
+        close(listener);
+        return 1;
+    }
+
+    stopping = 0;
+    handle_signals(stop);
+
+    int res = 1;
+
+    while (true) {
+        int connection = accept(listener, nullptr, nullptr);
+
+        // The children which answered
+        while (waitpid(-1, nullptr, WNOHANG) > 0)
+            ;
+
+        if (connection < 0) {
+            if (stopping) {
+                res = 0;
+                break;
+            }
+
+            if (errno == EINTR)
+                continue;
+
+            cerr << "cannot accept a connection on " << socket_path << ": " << strerror(errno) << '\n';
+            break;
+        }
+
+        serve(listener, connection);
+        close(connection);
+    }
+
+    close(listener);
+    unlink(socket_path.c_str());
+
+    // The requests being answered
+    while (wait(nullptr) > 0 || errno == EINTR)
+        ;
+
+    handle_signals(SIG_DFL);
+
+    return res;
+}
+
+void Server::serve(int listener, int connection) {
+    // A client which does not send its request does not block the others
+    timeval timeout = {5, 0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    string data;
+    if (!read_all(connection, data))
+        return;
+
+    // Null terminated strings
+    vector<string> request;
+    for (size_t begin = 0, end; (end = data.find('\0', begin)) != string::npos; begin = end + 1)
+        request.emplace_back(data, begin, end - begin);
+
+    if (request.empty())
+        return;
+
+    if (request.size() == 3 && request[1] == "-c") {
+        ostringstream out, err;
+        int res = check(request[0], request[2], out, err);
+
+        answer(connection, res, out.str(), err.str());
+        return;
+    }
+
+    pid_t pid = fork();
+
+    if (pid < 0) {
+        answer(connection, 1, "", string("cannot run the command: ") + strerror(errno) + "\n");
+        return;
+    }
+
+    // The child answers
+    if (pid > 0)
+        return;
+
+    close(listener);
+    handle_signals(SIG_DFL);
+
+    // The output of the command is written by this process only
+    ostringstream out, err;
+    streambuf *saved_out = cout.rdbuf(out.rdbuf());
+    streambuf *saved_err = cerr.rdbuf(err.rdbuf());
+
+    int res = handle(request);
+
+    cout.flush();
+    cout.rdbuf(saved_out);
+    cerr.rdbuf(saved_err);
+
+    answer(connection, res, out.str(), err.str());
+    close(connection);
+
+    _exit(0);
+}
+
+int Server::handle(const vector<string> &request) {
+    const string &directory = request[0];
+    vector<string> args(request.begin() + 1, request.end());
+
+    // The file names are relative to the directory of the client
+    if (chdir(directory.c_str()) != 0) {
+        cerr << "cannot change directory to " << directory << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+
+    try {
+        return compile(args);
+    } catch (const SemanticError &e) {
+        // The command would have exited
+        cerr << e.message;
+        return 1;
+    }
+}
+
+int Server::check(const string &directory, const string &file, ostream &out, ostream &err) {
+    // The server stays in its own directory
+    string path = !file.empty() && file[0] == '/' ? file : directory + "/" + file;
+
+    ifstream stream(path, ios::binary);
+    if (!stream) {
+        err << "cannot open " << file << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+
+    ostringstream text;
+    text << stream.rdbuf();
+    string source = text.str();
+
+    unique_ptr<Document> &document = find_document(make_pair(directory, file));
+
+    if (!document) {
+        document.reset(new Document(file, std::move(source)));
+    } else {
+        // Replace the range between the common prefix and suffix of the
+        // previous and the new source
+        const string &previous = document->get_source();
+        size_t common = min(previous.size(), source.size());
+
+        size_t prefix = 0;
+        while (prefix < common && previous[prefix] == source[prefix])
+            prefix++;
+
+        size_t suffix = 0;
+        while (suffix < common - prefix
+               && previous[previous.size() - 1 - suffix] == source[source.size() - 1 - suffix])
+            suffix++;
+
+        if (prefix != previous.size() || previous.size() != source.size())
+            document->edit(prefix, previous.size() - prefix - suffix,
+                           source.substr(prefix, source.size() - prefix - suffix));
+    }
+
+    checkMode = true;
+
+    if (document->check(err) != 0)
+        return 1;
+
+    out << document->get_program()->evaluate() << endl;
+
+    return 0;
+}
+
+unique_ptr<Document> &Server::find_document(const Key &key) {
+    auto found = index.find(key);
+
+    if (found != index.end()) {
+        documents.splice(documents.begin(), documents, found->second);
+        return documents.front().second;
+    }
+
+    if (documents.size() >= MAX_DOCUMENTS) {
+        index.erase(documents.back().first);
+        documents.pop_back();
+    }
+
+    documents.emplace_front(key, nullptr);
+    index[key] = documents.begin();
+
+    return documents.front().second;
+}
+
+bool Server::forward(const string &socket_path, const vector<string> &args, int &res) {
+    sockaddr_un address;
+    int fd = open_socket(socket_path, address);
+
+    if (fd < 0)
+        return false;
+
+    if (connect(fd, (sockaddr *) &address, sizeof(address)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    char directory[PATH_MAX];
+    if (!getcwd(directory, sizeof(directory))) {
+        close(fd);
+        return false;
+    }
+
+    string request = string(directory) + '\0';
+    for (const string &arg : args)
+        request += arg + '\0';
+
+    string answer;
+    bool ok = write_all(fd, request.data(), request.size())
+           && shutdown(fd, SHUT_WR) == 0
+           && read_all(fd, answer);
+
+    close(fd);
+
+    // Header "<exit code> <output length> <error length>"
+    size_t out_size, err_size;
+    size_t header = answer.find('\n');
+    if (!ok || header == string::npos
+        || sscanf(answer.c_str(), "%d %zu %zu", &res, &out_size, &err_size) != 3
+        || answer.size() - header - 1 != out_size + err_size)
+        return false;
+
+    cout.write(answer.data() + header + 1, out_size);
+    cout.flush();
+    cerr.write(answer.data() + header + 1 + out_size, err_size);
+
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef _SERVER_HPP
+#define _SERVER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "document.hpp"
+
+namespace VSOP {
+    /**
+     * @brief Runs the compiler on requests received on a Unix socket, to
+     * avoid starting a new process for each compilation.
+     *
+     * A request is the working directory and the arguments of a vsopc
+     * command, its answer is the exit code and what the command wrote on
+     * the standard output and error. The checks (-c) of a file keep its
+     * tokens, AST and tables, as in the daemon mode, and only the part of
+     * the file that changed since its previous check is checked again.
+     *
+     * The checks are run one at a time by the server, which keeps the
+     * files. The other commands are run concurrently, each by a child
+     * process forked for its connection, in the directory of its client.
+     */
+    class Server {
+        public:
+            /**
+             * @brief The compilation run for the other requests.
+             */
+            typedef std::function<int(const std::vector<std::string> &)> Compile;
+
+            /**
+             * @brief Construct a new Server.
+             *
+             * @param socket_path The path of the socket.
+             * @param compile Run a vsopc command on its arguments.
+             */
+            Server(const std::string &socket_path, Compile compile);
+
+            /**
+             * @brief Answer the requests until an error occurs or SIGINT or
+             * SIGTERM is received.
+             *
+             * @return int The exit code.
+             */
+            int run();
+
+            /**
+             * @brief Run a vsopc command by a server.
+             *
+             * @param socket_path The path of the socket of the server.
+             * @param args The arguments of the command.
+             * @param res Receives the exit code of the command.
+             *
+             * @return bool false if there is no server.
+             */
+            static bool forward(const std::string &socket_path, const std::vector<std::string> &args,
+                                int &res);
+
+        private:
+            /**
+             * @brief The number of files kept, the least recently checked
+             * one is dropped for a new one.
+             */
+            static const std::size_t MAX_DOCUMENTS = 64;
+
+            /**
+             * @brief A working directory and a file name.
+             */
+            typedef std::pair<std::string, std::string> Key;
+
+            typedef std::list<std::pair<Key, std::unique_ptr<Document>>> Documents;
+
+            std::string socket_path;
+            Compile compile;
+
+            /**
+             * @brief The checked files, the most recently checked first.
+             */
+            Documents documents;
+
+            /**
+             * @brief The checked files, by working directory and name.
+             */
+            std::map<Key, Documents::iterator> index;
+
+            /**
+             * @brief Answer the request of a client.
+             *
+             * @param listener The listening socket, closed by a child process.
+             * @param connection The socket connected to the client.
+             */
+            void serve(int listener, int connection);
+
+            /**
+             * @brief Run a command in the child process of its connection,
+             * its output is written on the standard output and error.
+             *
+             * @param request The working directory, then the arguments.
+             *
+             * @return int The exit code.
+             */
+            int handle(const std::vector<std::string> &request);
+
+            /**
+             * @brief Check a file, reusing its previous check.
+             *
+             * @param directory The working directory of the client.
+             * @param file The name of the file, relative to the directory.
+             * @param out The stream of the AST.
+             * @param err The stream of the errors.
+             *
+             * @return int The exit code.
+             */
+            int check(const std::string &directory, const std::string &file,
+                      std::ostream &out, std::ostream &err);
+
+            /**
+             * @brief Get the document of a file, the least recently checked
+             * one is dropped if there are too many.
+             *
+             * @return std::unique_ptr<Document>& Null for a new file.
+             */
+            std::unique_ptr<Document> &find_document(const Key &key);
+    };
+}
+
+#endif
@@ -0,0 +1,295 @@
+#include "sixthPass.hpp"
+#include "stats.hpp"
+
+/*
+    Sixth pass, over the optimized AST, removing the classes and methods the program cannot use before code
+    generation. Starting from Main.main, a method is kept when a call may dispatch to it: the call is resolved
+    against its static type and against every class instantiated by the code kept that conforms to it.
+*/
+
+SixthPass::SixthPass(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes, const std::vector<std::string>& classOrder): classInfoMap_(classInfoMap), classMethodTypes_(classMethodTypes), classFieldTypes_(classFieldTypes), classMethodFormalsTypes_(classMethodFormalsTypes), classOrder_(classOrder) {}
+
+// ProgramNode --> the methods reachable from Main.main, then the removal of the others
+void SixthPass::visit(AST::ProgramNode* node) {
+    for (auto& classNode : node->getClasses()) {
+        for (auto& methodNode : classNode->getClassBody()->getMethods()) {
+            methodNodes_[classNode->getName()][methodNode->getName()] = methodNode;
+        }
+    }
+
+    // The methods of Object are in the runtime, they are always kept
+    markClass("Object");
+    for (const auto& method : methodNodes_["Object"]) {
+        liveMethods_["Object"].insert(method.first);
+    }
+
+    instantiate("Main");
+    markMethod("Main", "main");
+
+    while (!queue_.empty()) {
+        AST::AstNode* member = queue_.back();
+        queue_.pop_back();
+        member->accept(this);
+    }
+
+    prune(node);
+}
+
+// FieldNode --> ExprNode
+void SixthPass::visit(AST::FieldNode* node) {
+    if (node->getInitExpr() != NULL) {
+        node->getInitExpr()->accept(this);
+    }
+}
+
+// MethodNode --> BlockNode
+void SixthPass::visit(AST::MethodNode* node) {
+    if (node->getBlock() != NULL) {
+        node->getBlock()->accept(this);
+    }
+}
+
+// BlockNode --> ExprNode
+void SixthPass::visit(AST::BlockNode* node) {
+    for (auto& exprNode : node->getExpr()) {
+        exprNode->accept(this);
+    }
+}
+
+// IfThenElseExprNode --> ExprNode
+void SixthPass::visit(AST::IfThenElseExprNode* node) {
+    node->getCondExpr()->accept(this);
+    node->getThenExpr()->accept(this);
+    if (node->getElseExpr() != NULL) {
+        node->getElseExpr()->accept(this);
+    }
+}
+
+// WhileDoExprNode --> ExprNode
+void SixthPass::visit(AST::WhileDoExprNode* node) {
+    node->getCondExpr()->accept(this);
+    node->getBodyExpr()->accept(this);
+}
+
+// LetExprNode --> TypeNode and ExprNode
+void SixthPass::visit(AST::LetExprNode* node) {
+    markClass(node->getTypeNode()->getTypeStr());
+
+    if (node->getInitExpr() != NULL) {
+        node->getInitExpr()->accept(this);
+    }
+    node->getScopeExpr()->accept(this);
+}
+
+// AssignExprNode --> ExprNode
+void SixthPass::visit(AST::AssignExprNode* node) {
+    node->getExpr()->accept(this);
+}
+
+void SixthPass::visitBinary(AST::BinaryExprNode* node) {
+    node->getLeftExpr()->accept(this);
+    node->getRightExpr()->accept(this);
+}
+
+void SixthPass::visit(AST::AndNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::EqualNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::LowerNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::LowerEqualNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::PlusNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::MinusNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::TimesNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::DivNode* node) { visitBinary(node); }
+void SixthPass::visit(AST::PowNode* node) { visitBinary(node); }
+
+void SixthPass::visit(AST::UnaryMinusNode* node) { node->getNode()->accept(this); }
+void SixthPass::visit(AST::NotNode* node) { node->getNode()->accept(this); }
+void SixthPass::visit(AST::IsNullNode* node) { node->getNode()->accept(this); }
+
+// NewExprNode, the class is instantiated
+void SixthPass::visit(AST::NewExprNode* node) {
+    instantiate(node->getTypeName());
+}
+
+// ParExprNode --> ExprNode
+void SixthPass::visit(AST::ParExprNode* node) {
+    node->getExpr()->accept(this);
+}
+
+// BlockExprNode --> BlockNode
+void SixthPass::visit(AST::BlockExprNode* node) {
+    node->getBlock()->accept(this);
+}
+
+// ArgsNode --> ExprNode
+void SixthPass::visit(AST::ArgsNode* node) {
+    for (auto& exprNode : node->getExprs()) {
+        exprNode->accept(this);
+    }
+}
+
+// CallExprNode --> ExprNode and ArgsNode, the method is called on the static type of the object
+void SixthPass::visit(AST::CallExprNode* node) {
+    AST::ExprNode* objExprNode = node->getObjExpr();
+    objExprNode->accept(this);
+
+    if (node->getExprList() != NULL) {
+        node->getExprList()->accept(this);
+    }
+
+    call(objExprNode->getTypename(), node->getMethodName());
+}
+
+// Keep a class with its ancestors and the types of its fields. Its fields are
+// initialized by the code generated for the class, even if it is never instantiated
+void SixthPass::markClass(const std::string& className) {
+    auto classIt = classInfoMap_.find(className);
+    if (classIt == classInfoMap_.end() || !liveClasses_.insert(className).second) {
+        return;
+    }
+
+    for (auto& fieldNode : classIt->second.classNode->getClassBody()->getFields()) {
+        markClass(fieldNode->getType()->getTypeStr());
+        queue_.push_back(fieldNode);
+    }
+
+    markClass(classIt->second.parentClassName);
+}
+
+// A class instantiated receives the calls made on the types it conforms to
+void SixthPass::instantiate(const std::string& className) {
+    markClass(className);
+    if (!instantiated_.insert(className).second) {
+        return;
+    }
+
+    for (const auto& called : calls_) {
+        if (conforms(className, called.first)) {
+            for (const auto& methodName : called.second) {
+                markMethod(className, methodName);
+            }
+        }
+    }
+}
+
+// The method of the static type is kept as well as the ones of the classes
+// instantiated, the code generation declares it in the layout of the type
+void SixthPass::call(const std::string& className, const std::string& methodName) {
+    markClass(className);
+    if (!calls_[className].insert(methodName).second) {
+        return;
+    }
+
+    markMethod(className, methodName);
+    for (const auto& instantiated : instantiated_) {
+        if (conforms(instantiated, className)) {
+            markMethod(instantiated, methodName);
+        }
+    }
+}
+
+// Keep the method a class dispatches a call to, and the types of its signature
+void SixthPass::markMethod(const std::string& className, const std::string& methodName) {
+    std::string definingClass = resolve(className, methodName);
+    if (definingClass.empty() || !liveMethods_[definingClass].insert(methodName).second) {
+        return;
+    }
+
+    AST::MethodNode* methodNode = methodNodes_[definingClass][methodName];
+    markClass(methodNode->getRetType()->getTypeStr());
+    for (auto& formalNode : methodNode->getFormals()->getFormals()) {
+        markClass(formalNode->getType()->getTypeStr());
+    }
+
+    queue_.push_back(methodNode);
+}
+
+// Class defining the method called on an object of the class, empty if none
+std::string SixthPass::resolve(const std::string& className, const std::string& methodName) const {
+    std::string currentClass = className;
+
+    // loop walks up class hierarchy
+    while (classInfoMap_.find(currentClass) != classInfoMap_.end()) {
+        auto classIt = methodNodes_.find(currentClass);
+        if (classIt != methodNodes_.end() && classIt->second.find(methodName) != classIt->second.end()) {
+            return currentClass;
+        }
+        currentClass = classInfoMap_.at(currentClass).parentClassName;
+    }
+    return "";
+}
+
+bool SixthPass::conforms(const std::string& className, const std::string& type) const {
+    std::string currentClass = className;
+
+    // loop walks up class hierarchy
+    while (classInfoMap_.find(currentClass) != classInfoMap_.end()) {
+        if (currentClass == type) {
+            return true;
+        }
+        currentClass = classInfoMap_.at(currentClass).parentClassName;
+    }
+    return false;
+}
+
+// Remove the classes and methods not kept from the AST and from the tables. The
+// classes removed are not freed, the table of FirstPass still refers to them
+void SixthPass::prune(AST::ProgramNode* node) {
+    std::size_t removedClasses = 0, removedMethods = 0;
+
+    std::vector<AST::ClassNode*> classes;
+    for (auto& classNode : node->getClasses()) {
+        const std::string& className = classNode->getName();
+
+        if (liveClasses_.find(className) == liveClasses_.end()) {
+            classInfoMap_.erase(className);
+            classMethodTypes_.erase(className);
+            classFieldTypes_.erase(className);
+            classMethodFormalsTypes_.erase(className);
+            removedClasses++;
+            continue;
+        }
+        classes.push_back(classNode);
+
+        const std::unordered_set<std::string>& liveMethods = liveMethods_[className];
+        std::vector<AST::MethodNode*> methods;
+        for (auto& methodNode : classNode->getClassBody()->getMethods()) {
+            if (liveMethods.find(methodNode->getName()) != liveMethods.end()) {
+                methods.push_back(methodNode);
+                continue;
+            }
+
+            classMethodTypes_[className].erase(methodNode->getName());
+            classMethodFormalsTypes_[className].erase(methodNode->getName());
+            delete methodNode;
+            removedMethods++;
+        }
+        classNode->getClassBody()->setMethods(methods);
+    }
+    node->setClasses(classes);
+
+    std::vector<std::string> classOrder;
+    for (auto& className : classOrder_) {
+        if (liveClasses_.find(className) != liveClasses_.end()) {
+            classOrder.push_back(className);
+        }
+    }
+    classOrder_ = std::move(classOrder);
+
+    stats.count("removed_classes", removedClasses);
+    stats.count("removed_methods", removedMethods);
+}
+
+// unused
+void SixthPass::visit(AST::ClassNode* /*node*/) {}
+void SixthPass::visit(AST::ClassBodyNode* /*node*/) {}
+void SixthPass::visit(AST::TypeNode* /*node*/) {}
+void SixthPass::visit(AST::FormalNode* /*node*/) {}
+void SixthPass::visit(AST::FormalsNode* /*node*/) {}
+void SixthPass::visit(AST::ExprNode* /*node*/) {}
+void SixthPass::visit(AST::BinaryExprNode* /*node*/) {}
+void SixthPass::visit(AST::UnaryExprNode* /*node*/) {}
+void SixthPass::visit(AST::VariableExprNode* /*node*/) {}
+void SixthPass::visit(AST::UnitExprNode* /*node*/) {}
+void SixthPass::visit(AST::IntegerLiteralNode* /*node*/) {}
+void SixthPass::visit(AST::LiteralNode* /*node*/) {}
+void SixthPass::visit(AST::BooleanLiteralNode* /*node*/) {}
@@ -0,0 +1,99 @@
+#ifndef SIXTH_PASS_HPP
+#define SIXTH_PASS_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast.hpp"
+#include "firstPass.hpp"
+
+class SixthPass : public AST::Visitor {
+public:
+    SixthPass(const std::unordered_map<std::string, FirstPass::ClassInfo>& classInfoMap, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes, const std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes, const std::vector<std::string>& classOrder);
+
+    // Tables of the classes and methods kept, for the code generation
+    const std::unordered_map<std::string, FirstPass::ClassInfo>& getClassInfoMap() const { return classInfoMap_; }
+    const std::unordered_map<std::string, std::unordered_map<std::string, std::string>>& getClassMethodTypes() const { return classMethodTypes_; }
+    const std::unordered_map<std::string, std::unordered_map<std::string, std::string>>& getClassFieldTypes() const { return classFieldTypes_; }
+    const std::unordered_map<std::string, std::unordered_map<std::string,
+    std::unordered_map<std::string, std::string>>>& getClassMethodFormalTypes() const { return classMethodFormalsTypes_; }
+    const std::vector<std::string>& getClassOrder() const { return classOrder_; }
+
+    void visit(AST::ProgramNode* node) override;
+    void visit(AST::FieldNode* node) override;
+    void visit(AST::MethodNode* node) override;
+    void visit(AST::BlockNode* node) override;
+    void visit(AST::IfThenElseExprNode* node) override;
+    void visit(AST::WhileDoExprNode* node) override;
+    void visit(AST::LetExprNode* node) override;
+    void visit(AST::AssignExprNode* node) override;
+    void visit(AST::AndNode* node) override;
+    void visit(AST::EqualNode* node) override;
+    void visit(AST::LowerNode* node) override;
+    void visit(AST::LowerEqualNode* node) override;
+    void visit(AST::PlusNode* node) override;
+    void visit(AST::MinusNode* node) override;
+    void visit(AST::TimesNode* node) override;
+    void visit(AST::DivNode* node) override;
+    void visit(AST::PowNode* node) override;
+    void visit(AST::UnaryMinusNode* node) override;
+    void visit(AST::NotNode* node) override;
+    void visit(AST::IsNullNode* node) override;
+    void visit(AST::NewExprNode* node) override;
+    void visit(AST::ParExprNode* node) override;
+    void visit(AST::BlockExprNode* node) override;
+    void visit(AST::ArgsNode* node) override;
+    void visit(AST::CallExprNode* node) override;
+
+    // unused
+    void visit(AST::ClassNode* node) override;
+    void visit(AST::ClassBodyNode* node) override;
+    void visit(AST::TypeNode* node) override;
+    void visit(AST::FormalNode* node) override;
+    void visit(AST::FormalsNode* node) override;
+    void visit(AST::ExprNode* node) override;
+    void visit(AST::BinaryExprNode* node) override;
+    void visit(AST::UnaryExprNode* node) override;
+    void visit(AST::VariableExprNode* node) override;
+    void visit(AST::UnitExprNode* node) override;
+    void visit(AST::IntegerLiteralNode* node) override;
+    void visit(AST::LiteralNode* node) override;
+    void visit(AST::BooleanLiteralNode* node) override;
+
+private:
+    std::unordered_map<std::string, FirstPass::ClassInfo> classInfoMap_;
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classMethodTypes_;
+    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> classFieldTypes_;
+    std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::string>>> classMethodFormalsTypes_;
+    std::vector<std::string> classOrder_;
+
+    // Method nodes by class and name
+    std::unordered_map<std::string, std::unordered_map<std::string, AST::MethodNode*>> methodNodes_;
+
+    // Classes kept: the ones instantiated, their ancestors and the types used by the code kept
+    std::unordered_set<std::string> liveClasses_;
+    std::unordered_set<std::string> instantiated_;
+
+    // Methods kept, by the class defining them
+    std::unordered_map<std::string, std::unordered_set<std::string>> liveMethods_;
+
+    // Methods called, by the static type of the object
+    std::unordered_map<std::string, std::unordered_set<std::string>> calls_;
+
+    // Fields and methods kept whose expressions are still to visit
+    std::vector<AST::AstNode*> queue_;
+
+    void markClass(const std::string& className);
+    void instantiate(const std::string& className);
+    void call(const std::string& className, const std::string& methodName);
+    void markMethod(const std::string& className, const std::string& methodName);
+
+    std::string resolve(const std::string& className, const std::string& methodName) const;
+    bool conforms(const std::string& className, const std::string& type) const;
+
+    void visitBinary(AST::BinaryExprNode* node);
+    void prune(AST::ProgramNode* node);
+};
+
+#endif // SIXTH_PASS_HPP
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+
+#include "stats.hpp"
+#include "ast.hpp"
+
+Stats stats;
+
+std::atomic<std::size_t> Stats::allocations(0);
+
+/*
+ *   Allocation counting
+ */
+
+void* operator new(std::size_t size) {
+    Stats::allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (size == 0)
+        size = 1;
+
+    while (true) {
+        void* ptr = std::malloc(size);
+        if (ptr != nullptr)
+            return ptr;
+
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+/*
+ *   Helpers
+ */
+
+// User and system CPU time of the process, in milliseconds.
+static double cpu_time() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3
+         + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+}
+
+// Peak resident set size of the process, in KiB.
+static long peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_maxrss;
+}
+
+static void print_at_exit() {
+    stats.end();
+    stats.print();
+}
+
+/*
+ *   Stats
+ */
+
+void Stats::enable(bool json) {
+    if (!enabled)
+        std::atexit(print_at_exit);
+
+    this->enabled = true;
+    this->json = json;
+}
+
+void Stats::begin(const std::string &name) {
+    if (!enabled)
+        return;
+
+    end();
+
+    Phase phase;
+    phase.name = name;
+    phases.push_back(phase);
+
+    running = true;
+    startNodes = AST::AstNode::count;
+    startAllocations = allocations;
+    startCpu = cpu_time();
+    startWall = std::chrono::steady_clock::now();
+}
+
+void Stats::end() {
+    if (!running)
+        return;
+
+    std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - startWall;
+
+    Phase &phase = phases.back();
+    phase.wall = wall.count();
+    phase.cpu = cpu_time() - startCpu;
+    phase.peakRss = peak_rss();
+    phase.allocations = allocations - startAllocations;
+    phase.nodes = AST::AstNode::count - startNodes;
+
+    running = false;
+}
+
+void Stats::count(const std::string &name, std::size_t value) {
+    if (!running)
+        return;
+
+    phases.back().counts.emplace_back(name, value);
+}
+
+void Stats::print() const {
+    if (json)
+        printJson();
+    else
+        printTable();
+}
+
+void Stats::printTable() const {
+    double totalWall = 0, totalCpu = 0;
+    std::size_t totalAllocations = 0, totalNodes = 0;
+    long peakRss = 0;
+    char line[128];
+
+    std::snprintf(line, sizeof(line), "%-10s %12s %12s %14s %12s %10s",
+                  "phase", "wall (ms)", "cpu (ms)", "peak rss (KiB)", "allocations", "nodes");
+    std::cerr << line << "\n";
+
+    for (const Phase &phase : phases) {
+        std::snprintf(line, sizeof(line), "%-10s %12.3f %12.3f %14ld %12zu %10zu",
+                      phase.name.c_str(), phase.wall, phase.cpu, phase.peakRss, phase.allocations, phase.nodes);
+        std::cerr << line;
+
+        for (const auto &counter : phase.counts)
+            std::cerr << "  " << counter.first << "=" << counter.second;
+        std::cerr << "\n";
+
+        totalWall += phase.wall;
+        totalCpu += phase.cpu;
+        totalAllocations += phase.allocations;
+        totalNodes += phase.nodes;
+        peakRss = phase.peakRss;
+    }
+
+    std::snprintf(line, sizeof(line), "%-10s %12.3f %12.3f %14ld %12zu %10zu",
+                  "total", totalWall, totalCpu, peakRss, totalAllocations, totalNodes);
+    std::cerr << line << std::endl;
+}
+
+void Stats::printJson() const {
+    char number[32];
+
+    std::cerr << "{\"phases\":[";
+
+    for (std::size_t i = 0; i < phases.size(); i++) {
+        const Phase &phase = phases[i];
+
+        if (i > 0)
+            std::cerr << ",";
+
+        std::cerr << "{\"name\":\"" << phase.name << "\"";
+        std::snprintf(number, sizeof(number), "%.3f", phase.wall);
+        std::cerr << ",\"wall_ms\":" << number;
+        std::snprintf(number, sizeof(number), "%.3f", phase.cpu);
+        std::cerr << ",\"cpu_ms\":" << number;
+        std::cerr << ",\"peak_rss_kib\":" << phase.peakRss
+                  << ",\"allocations\":" << phase.allocations
+                  << ",\"nodes\":" << phase.nodes;
+
+        for (const auto &counter : phase.counts)
+            std::cerr << ",\"" << counter.first << "\":" << counter.second;
+
+        std::cerr << "}";
+    }
+
+    std::cerr << "]}" << std::endl;
+}
@@ -0,0 +1,83 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Per-phase time and memory statistics of a compilation, enabled by --stats.
+ */
+class Stats {
+    public:
+        /**
+         * @brief Enable the statistics, they are printed on stderr when the program exits.
+         *
+         * @param json true to print a JSON object instead of a table.
+         */
+        void enable(bool json);
+
+        /**
+         * @brief End the current phase, if any, and start a new one.
+         *
+         * @param name The name of the phase.
+         */
+        void begin(const std::string &name);
+
+        /**
+         * @brief End the current phase.
+         */
+        void end();
+
+        /**
+         * @brief Attach a counter to the current phase.
+         *
+         * @param name The name of the counter.
+         * @param value The value of the counter.
+         */
+        void count(const std::string &name, std::size_t value);
+
+        /**
+         * @brief Print the statistics of the ended phases.
+         */
+        void print() const;
+
+        /**
+         * @brief Number of calls to operator new since the start of the
+         * program, on any thread.
+         */
+        static std::atomic<std::size_t> allocations;
+
+    private:
+        struct Phase {
+            std::string name;
+            double wall;
+            double cpu;
+            long peakRss;
+            std::size_t allocations;
+            std::size_t nodes;
+            std::vector<std::pair<std::string, std::size_t>> counts;
+        };
+
+        bool enabled = false;
+        bool json = false;
+        bool running = false;
+
+        std::vector<Phase> phases;
+
+        // Values at the start of the current phase
+        std::chrono::steady_clock::time_point startWall;
+        double startCpu;
+        std::size_t startAllocations;
+        std::size_t startNodes;
+
+        void printTable() const;
+        void printJson() const;
+};
+
+extern Stats stats;
+
+#endif // STATS_HPP
@@ -26,6 +26,13 @@ void ThirdPass::visit(AST::ProgramNode* node) {
     checkMainMethod(node);
 }
 
+// ClassNode --> forget its formals + ClassNode
+void ThirdPass::recheckClass(AST::ClassNode* node) {
+    classMethodFormalTypes_.erase(node->getName());
+
+    node->accept(this);
+}
+
 // ClassNode --> ClassBodyNode
 void ThirdPass::visit(AST::ClassNode* node) {
     currentClassName_ = node->getName();
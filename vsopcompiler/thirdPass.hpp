@@ -14,6 +14,9 @@ public:
     const std::unordered_map<std::string, std::unordered_map<std::string,
     std::unordered_map<std::string, std::string>>>& getClassMethodFormalTypes() const;
 
+    // Check again a class parsed again, with the same declaration
+    void recheckClass(AST::ClassNode* node);
+
     void visit(AST::ProgramNode* node) override;
     void visit(AST::ClassNode* node) override;
     void visit(AST::ClassBodyNode* node) override;
@@ -0,0 +1,221 @@
+#include <utility>
+
+#include "tokenStore.hpp"
+
+using namespace std;
+using namespace VSOP;
+
+void TokenStore::set_source(string source) {
+    this->source = std::move(source);
+
+    clear();
+}
+
+void TokenStore::clear() {
+    kinds.clear();
+    offsets.clear();
+    lengths.clear();
+    positions.clear();
+}
+
+void TokenStore::push(Parser::token_type kind, size_t offset, size_t length,
+                      const position &begin) {
+    kinds.push_back((uint8_t) kind);
+    offsets.push_back((uint32_t) offset);
+    lengths.push_back((uint32_t) length);
+    positions.push_back(((uint64_t) (uint32_t) begin.line << 32) | (uint32_t) begin.column);
+}
+
+void TokenStore::append(const TokenStore &tokens, int lines) {
+    kinds.insert(kinds.end(), tokens.kinds.begin(), tokens.kinds.end());
+    offsets.insert(offsets.end(), tokens.offsets.begin(), tokens.offsets.end());
+    lengths.insert(lengths.end(), tokens.lengths.begin(), tokens.lengths.end());
+
+    uint64_t shift = (uint64_t) (uint32_t) lines << 32;
+    positions.reserve(positions.size() + tokens.size());
+    for (uint64_t position : tokens.positions)
+        positions.push_back(position + shift);
+}
+
+void TokenStore::edit_source(size_t offset, size_t removed, const string &text) {
+    source.replace(offset, removed, text);
+}
+
+void TokenStore::replace(size_t begin, size_t end, const TokenStore &tokens) {
+    kinds.erase(kinds.begin() + begin, kinds.begin() + end);
+    offsets.erase(offsets.begin() + begin, offsets.begin() + end);
+    lengths.erase(lengths.begin() + begin, lengths.begin() + end);
+    positions.erase(positions.begin() + begin, positions.begin() + end);
+
+    kinds.insert(kinds.begin() + begin, tokens.kinds.begin(), tokens.kinds.end());
+    offsets.insert(offsets.begin() + begin, tokens.offsets.begin(), tokens.offsets.end());
+    lengths.insert(lengths.begin() + begin, tokens.lengths.begin(), tokens.lengths.end());
+    positions.insert(positions.begin() + begin, tokens.positions.begin(), tokens.positions.end());
+}
+
+void TokenStore::shift(size_t begin, ptrdiff_t offset, int lines, int columns) {
+    if (begin == size())
+        return;
+
+    int first_line = line(begin);
+
+    for (size_t i = begin; i < size(); i++) {
+        int l = line(i);
+        int c = l == first_line ? column(i) + columns : column(i);
+
+        offsets[i] = (uint32_t) (offsets[i] + offset);
+        positions[i] = ((uint64_t) (uint32_t) (l + lines) << 32) | (uint32_t) c;
+    }
+}
+
+int TokenStore::integer(size_t i) const {
+    // The lexer only keeps the literals in range
+    int value = 0;
+    decode_integer(lexeme(i), length(i), value);
+    return value;
+}
+
+void TokenStore::string_literal(size_t i, string &out) const {
+    decode_string(lexeme(i) + 1, lexeme(i) + length(i) - 1, out);
+}
+
+Parser::symbol_type TokenStore::symbol(size_t i, string *filename) const {
+    location loc(filename, line(i), column(i));
+    loc.columns(length(i));
+
+    switch (kind(i)) {
+        case Parser::token::TYPE_IDENTIFIER:
+            return Parser::make_TYPE_IDENTIFIER(string(lexeme(i), length(i)), loc);
+
+        case Parser::token::OBJECT_IDENTIFIER:
+            return Parser::make_OBJECT_IDENTIFIER(string(lexeme(i), length(i)), loc);
+
+        case Parser::token::INTEGER_LITERAL:
+            return Parser::make_INTEGER_LITERAL(integer(i), loc);
+
+        case Parser::token::STRING_LITERAL: {
+            string s;
+            string_literal(i, s);
+            return Parser::make_STRING_LITERAL(std::move(s), loc);
+        }
+
+        default:
+            return Parser::symbol_type(kind(i), loc);
+    }
+}
+
+/**
+ * @brief Tables indexed by the bytes of a literal.
+ */
+struct LiteralTables {
+    /**
+     * @brief Value of a hexadecimal digit, -1 for other bytes.
+     */
+    signed char digits[256];
+
+    /**
+     * @brief Value of a single-character escape sequence, by the byte
+     * following the backslash, 0 for other bytes.
+     */
+    char escapes[256];
+
+    /**
+     * @brief The byte is printed as it is, the other bytes are printed
+     * as a hexadecimal escape sequence.
+     */
+    bool plain[256];
+};
+
+static constexpr LiteralTables make_literal_tables() {
+    LiteralTables tables = {};
+
+    for (int c = 0; c < 256; c++) {
+        tables.digits[c] = -1;
+        tables.plain[c] = c >= 32 && c <= 126 && c != '"' && c != '\\';
+    }
+
+    for (int c = '0'; c <= '9'; c++)
+        tables.digits[c] = (signed char) (c - '0');
+    for (int c = 'a'; c <= 'f'; c++) {
+        tables.digits[c] = (signed char) (c - 'a' + 10);
+        tables.digits[c - 'a' + 'A'] = (signed char) (c - 'a' + 10);
+    }
+
+    tables.escapes['b'] = '\b';
+    tables.escapes['t'] = '\t';
+    tables.escapes['n'] = '\n';
+    tables.escapes['r'] = '\r';
+    tables.escapes['"'] = '"';
+    tables.escapes['\\'] = '\\';
+
+    return tables;
+}
+
+static constexpr LiteralTables tables = make_literal_tables();
+
+bool TokenStore::decode_integer(const char *s, size_t length, int &value) {
+    const char *end = s + length;
+    unsigned base = 10;
+
+    if (length > 2 && s[0] == '0' && s[1] == 'x') {
+        base = 16;
+        s += 2;
+    }
+
+    // Stop before the value gets past INT_MAX
+    const uint32_t max = 0x7fffffff;
+    uint32_t result = 0;
+
+    for (; s < end; ++s) {
+        uint32_t digit = (uint32_t) tables.digits[(unsigned char) *s];
+        if (result > (max - digit) / base)
+            return false;
+        result = result * base + digit;
+    }
+
+    value = (int) result;
+    return true;
+}
+
+void TokenStore::decode_string(const char *s, const char *end, string &out) {
+    static const char hex[] = "0123456789abcdef";
+
+    // A byte of the literal is printed in at most 4 characters, the buffer
+    // of out is reused if large enough
+    out.resize(4 * (size_t) (end - s));
+    char *o = &out[0];
+
+    while (s < end) {
+        unsigned char c = (unsigned char) *s++;
+
+        if (c == '\\') {
+            unsigned char e = (unsigned char) *s++;
+
+            if (e == 'x') {
+                c = (unsigned char) (tables.digits[(unsigned char) s[0]] * 16 + tables.digits[(unsigned char) s[1]]);
+                s += 2;
+            } else if (e == '\n') {
+                // Line continuation, the following blanks are skipped
+                while (s < end && (*s == ' ' || *s == '\t'))
+                    ++s;
+                continue;
+            } else
+                c = (unsigned char) tables.escapes[e];
+        }
+
+        // The value ends at the first null character
+        if (c == 0)
+            break;
+
+        if (tables.plain[c])
+            *o++ = (char) c;
+        else {
+            *o++ = '\\';
+            *o++ = 'x';
+            *o++ = hex[c >> 4];
+            *o++ = hex[c & 0xf];
+        }
+    }
+
+    out.resize((size_t) (o - out.data()));
+}
@@ -0,0 +1,162 @@
+#ifndef _TOKEN_STORE_HPP
+#define _TOKEN_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+
+namespace VSOP {
+    /**
+     * @brief The tokens of a source file, stored as a structure of arrays.
+     *
+     * A token is its kind, the offset and length of its lexeme in the
+     * source, and its begin position packed in 64 bits. Payloads of
+     * identifiers and literals are decoded from the source on demand.
+     */
+    class TokenStore {
+        public:
+            /**
+             * @brief Set the source the tokens refer to, and remove all the tokens.
+             *
+             * @param source The content of the source file.
+             */
+            void set_source(std::string source);
+
+            /**
+             * @brief Remove all the tokens.
+             */
+            void clear();
+
+            /**
+             * @brief Get the source the tokens refer to.
+             */
+            const std::string &get_source() const { return source; }
+
+            /**
+             * @brief Add a token.
+             *
+             * @param kind The kind of the token.
+             * @param offset The offset of the lexeme in the source.
+             * @param length The length of the lexeme.
+             * @param begin The position of the beginning of the token.
+             */
+            void push(Parser::token_type kind, std::size_t offset, std::size_t length,
+                      const position &begin);
+
+            /**
+             * @brief Add the tokens of another store at the end.
+             *
+             * @param tokens The tokens, their offsets refer to this source.
+             * @param lines The number of lines added to their positions.
+             */
+            void append(const TokenStore &tokens, int lines);
+
+            /**
+             * @brief Replace a range of the source. The tokens are left as
+             * they are, see replace() and shift().
+             *
+             * @param offset The offset of the range.
+             * @param removed The length of the range.
+             * @param text The text replacing the range.
+             */
+            void edit_source(std::size_t offset, std::size_t removed, const std::string &text);
+
+            /**
+             * @brief Replace a range of tokens by the tokens of another store.
+             *
+             * @param begin The index of the first token replaced.
+             * @param end The index following the last token replaced.
+             * @param tokens The new tokens, their offsets refer to this source.
+             */
+            void replace(std::size_t begin, std::size_t end, const TokenStore &tokens);
+
+            /**
+             * @brief Move the tokens from an index to the end of the store.
+             *
+             * The column only changes on the line of the first token moved,
+             * the following lines start at the same column as before.
+             *
+             * @param begin The index of the first token moved.
+             * @param offset The change of offset.
+             * @param lines The change of line.
+             * @param columns The change of column on the first line.
+             */
+            void shift(std::size_t begin, std::ptrdiff_t offset, int lines, int columns);
+
+            /**
+             * @brief Get the number of tokens.
+             */
+            std::size_t size() const { return kinds.size(); }
+
+            Parser::token_type kind(std::size_t i) const { return (Parser::token_type) kinds[i]; }
+
+            std::size_t offset(std::size_t i) const { return offsets[i]; }
+
+            const char *lexeme(std::size_t i) const { return source.data() + offsets[i]; }
+
+            std::size_t length(std::size_t i) const { return lengths[i]; }
+
+            int line(std::size_t i) const { return (int) (positions[i] >> 32); }
+
+            int column(std::size_t i) const { return (int) (positions[i] & 0xffffffff); }
+
+            /**
+             * @brief Get the value of an integer literal token.
+             */
+            int integer(std::size_t i) const;
+
+            /**
+             * @brief Get the value of a string literal token, as printed by
+             * the lexer.
+             *
+             * @param i The index of the token.
+             * @param out The string receiving the value.
+             */
+            void string_literal(std::size_t i, std::string &out) const;
+
+            /**
+             * @brief Rebuild the bison symbol of a token, with its payload.
+             *
+             * Only the begin of the location is kept, the end is the begin
+             * moved by the length of the lexeme.
+             *
+             * @param i The index of the token.
+             * @param filename The filename of the location.
+             */
+            Parser::symbol_type symbol(std::size_t i, std::string *filename) const;
+
+            /**
+             * @brief Get the value of an integer literal.
+             *
+             * @param s The lexeme of the literal.
+             * @param length The length of the lexeme.
+             * @param value Receives the value.
+             *
+             * @return bool false if the value does not fit in an int.
+             */
+            static bool decode_integer(const char *s, std::size_t length, int &value);
+
+            /**
+             * @brief Decode a string literal and escape it as printed by the
+             * lexer. The value ends at the first null character.
+             *
+             * @param s The characters of the literal, after the opening quote.
+             * @param end The closing quote.
+             * @param out The string receiving the escaped literal.
+             */
+            static void decode_string(const char *s, const char *end, std::string &out);
+
+        private:
+            std::string source;
+
+            std::vector<std::uint8_t> kinds;
+            std::vector<std::uint32_t> offsets;
+            std::vector<std::uint32_t> lengths;
+            std::vector<std::uint64_t> positions;
+    };
+}
+
+#endif
@@ -2,18 +2,33 @@
 #define UTILS_HPP
 
 #include <iostream>
+#include <sstream>
 #include <string>
 
+// Set when the compiler runs as a long-lived process, error() then throws
+// a SemanticError with the message instead of writing it and exiting.
+extern bool recoverableErrors;
+
+struct SemanticError {
+    // The line reported, written by the catcher on the stream of its request
+    std::string message;
+};
+
 inline void error(const std::string& filename, const int line, const int column, const std::string& m) {
 
-    std::cerr << filename << ":"
-         << line << ":" 
+    std::ostringstream message;
+    message << filename << ":"
+         << line << ":"
          << column << ": "
          << " semantic error: "
          << m
-         << std::endl;
+         << "\n";
+
+         if (recoverableErrors)
+             throw SemanticError{message.str()};
 
+         std::cerr << message.str() << std::flush;
          exit(1);
 }
 
-#endif // UTILS_HPP
\ No newline at end of file
+#endif // UTILS_HPP
@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "xref.hpp"
+
+using namespace std;
+using namespace VSOP;
+
+static const char magic[4] = {'V', 'X', 'R', 'F'};
+static const uint32_t version = 1;
+
+static const char *kind_names[] = {"class", "field", "method"};
+
+namespace VSOP {
+    /**
+     * @brief Collects the symbols of a checked program and the references
+     * to them, then writes the index.
+     *
+     * The identifiers are bound as in FourthPass: to the innermost let or
+     * formal of the same name, else to the field of the current class or
+     * of an ancestor. The calls are resolved on the static type of their
+     * object, given by FourthPass.
+     */
+    class XrefBuilder : public AST::Visitor {
+        public:
+            XrefBuilder(const unordered_map<string, FirstPass::ClassInfo> &classInfoMap,
+                        const unordered_map<string, unordered_map<string, string>> &classMethodTypes,
+                        const unordered_map<string, unordered_map<string, string>> &classFieldTypes)
+            : classInfoMap(classInfoMap), classMethodTypes(classMethodTypes), classFieldTypes(classFieldTypes) {}
+
+            bool write(const string &index_file, const string &source_file) const;
+
+            void visit(AST::ProgramNode *node) override;
+            void visit(AST::ClassNode *node) override;
+            void visit(AST::FieldNode *node) override;
+            void visit(AST::MethodNode *node) override;
+            void visit(AST::BlockNode *node) override;
+            void visit(AST::IfThenElseExprNode *node) override;
+            void visit(AST::WhileDoExprNode *node) override;
+            void visit(AST::LetExprNode *node) override;
+            void visit(AST::AssignExprNode *node) override;
+            void visit(AST::AndNode *node) override { visitBinary(node); }
+            void visit(AST::EqualNode *node) override { visitBinary(node); }
+            void visit(AST::LowerNode *node) override { visitBinary(node); }
+            void visit(AST::LowerEqualNode *node) override { visitBinary(node); }
+            void visit(AST::PlusNode *node) override { visitBinary(node); }
+            void visit(AST::MinusNode *node) override { visitBinary(node); }
+            void visit(AST::TimesNode *node) override { visitBinary(node); }
+            void visit(AST::DivNode *node) override { visitBinary(node); }
+            void visit(AST::PowNode *node) override { visitBinary(node); }
+            void visit(AST::UnaryMinusNode *node) override { node->getNode()->accept(this); }
+            void visit(AST::NotNode *node) override { node->getNode()->accept(this); }
+            void visit(AST::IsNullNode *node) override { node->getNode()->accept(this); }
+            void visit(AST::NewExprNode *node) override;
+            void visit(AST::VariableExprNode *node) override;
+            void visit(AST::ParExprNode *node) override { node->getExpr()->accept(this); }
+            void visit(AST::BlockExprNode *node) override { node->getBlock()->accept(this); }
+            void visit(AST::ArgsNode *node) override;
+            void visit(AST::CallExprNode *node) override;
+
+            // unused
+            void visit(AST::ClassBodyNode *) override {}
+            void visit(AST::TypeNode *) override {}
+            void visit(AST::FormalNode *) override {}
+            void visit(AST::FormalsNode *) override {}
+            void visit(AST::ExprNode *) override {}
+            void visit(AST::BinaryExprNode *) override {}
+            void visit(AST::UnaryExprNode *) override {}
+            void visit(AST::UnitExprNode *) override {}
+            void visit(AST::IntegerLiteralNode *) override {}
+            void visit(AST::LiteralNode *) override {}
+            void visit(AST::BooleanLiteralNode *) override {}
+
+        private:
+            struct Entry {
+                uint32_t kind;
+                string className;
+                string name;
+                uint32_t line;
+                uint32_t column;
+            };
+
+            struct Use {
+                uint32_t symbol;
+                uint32_t line;
+                uint32_t column;
+                uint32_t from;
+            };
+
+            const unordered_map<string, FirstPass::ClassInfo> &classInfoMap;
+            const unordered_map<string, unordered_map<string, string>> &classMethodTypes;
+            const unordered_map<string, unordered_map<string, string>> &classFieldTypes;
+
+            vector<Entry> entries;
+            unordered_map<string, uint32_t> ids;
+            vector<Use> uses;
+
+            string currentClass;
+            uint32_t current = 0;
+
+            // Lets and formals in scope, the innermost last
+            vector<string> locals;
+
+            static string key(uint32_t kind, const string &className, const string &name) {
+                return to_string(kind) + className + "." + name;
+            }
+
+            void declare(uint32_t kind, const string &className, const string &name, int line, int column);
+            void use(uint32_t kind, const string &className, const string &name, int line, int column);
+            void useType(AST::TypeNode *node);
+            void useField(const string &name, int line, int column);
+
+            // Class defining a member for an object of a class, empty if none
+            string definingClass(const string &className, const string &name,
+                                 const unordered_map<string, unordered_map<string, string>> &members) const;
+
+            void visitBinary(AST::BinaryExprNode *node) {
+                node->getLeftExpr()->accept(this);
+                node->getRightExpr()->accept(this);
+            }
+    };
+}
+
+void XrefBuilder::declare(uint32_t kind, const string &className, const string &name, int line, int column) {
+    if (ids.emplace(key(kind, className, name), entries.size()).second)
+        entries.push_back({kind, className, name, (uint32_t) line, (uint32_t) column});
+}
+
+void XrefBuilder::use(uint32_t kind, const string &className, const string &name, int line, int column) {
+    auto it = ids.find(key(kind, className, name));
+    if (it != ids.end())
+        uses.push_back({it->second, (uint32_t) line, (uint32_t) column, current});
+}
+
+void XrefBuilder::useType(AST::TypeNode *node) {
+    if (classInfoMap.count(node->getTypeStr()))
+        use(Xref::CLASS, node->getTypeStr(), "", node->getLine(), node->getColumn());
+}
+
+void XrefBuilder::useField(const string &name, int line, int column) {
+    if (name == "self" || find(locals.begin(), locals.end(), name) != locals.end())
+        return;
+
+    string definer = definingClass(currentClass, name, classFieldTypes);
+    if (!definer.empty())
+        use(Xref::FIELD, definer, name, line, column);
+}
+
+string XrefBuilder::definingClass(const string &className, const string &name,
+                                  const unordered_map<string, unordered_map<string, string>> &members) const {
+    string ancestor = className;
+
+    // loop walks up class hierarchy
+    while (classInfoMap.count(ancestor)) {
+        auto classIt = members.find(ancestor);
+        if (classIt != members.end() && classIt->second.count(name))
+            return ancestor;
+
+        ancestor = classInfoMap.at(ancestor).parentClassName;
+    }
+
+    return "";
+}
+
+// All the symbols are declared before the references to them
+void XrefBuilder::visit(AST::ProgramNode *node) {
+    for (auto &classNode : node->getClasses()) {
+        const string &className = classNode->getName();
+        declare(Xref::CLASS, className, "", classNode->getLine(), classNode->getColumn());
+
+        for (auto &fieldNode : classNode->getClassBody()->getFields())
+            declare(Xref::FIELD, className, fieldNode->getName(), fieldNode->getLine(), fieldNode->getColumn());
+        for (auto &methodNode : classNode->getClassBody()->getMethods())
+            declare(Xref::METHOD, className, methodNode->getName(), methodNode->getLine(), methodNode->getColumn());
+    }
+
+    for (auto &classNode : node->getClasses())
+        classNode->accept(this);
+}
+
+void XrefBuilder::visit(AST::ClassNode *node) {
+    currentClass = node->getName();
+    current = ids.at(key(Xref::CLASS, currentClass, ""));
+
+    if (!node->getParent().empty())
+        use(Xref::CLASS, node->getParent(), "", node->getLine(), node->getColumn());
+
+    for (auto &fieldNode : node->getClassBody()->getFields())
+        fieldNode->accept(this);
+    for (auto &methodNode : node->getClassBody()->getMethods())
+        methodNode->accept(this);
+}
+
+void XrefBuilder::visit(AST::FieldNode *node) {
+    current = ids.at(key(Xref::FIELD, currentClass, node->getName()));
+    locals.clear();
+
+    useType(node->getType());
+    if (node->getInitExpr() != NULL)
+        node->getInitExpr()->accept(this);
+}
+
+void XrefBuilder::visit(AST::MethodNode *node) {
+    current = ids.at(key(Xref::METHOD, currentClass, node->getName()));
+    locals.clear();
+
+    for (auto &formalNode : node->getFormals()->getFormals()) {
+        useType(formalNode->getType());
+        locals.push_back(formalNode->getName());
+    }
+    useType(node->getRetType());
+
+    if (node->getBlock() != NULL)
+        node->getBlock()->accept(this);
+}
+
+void XrefBuilder::visit(AST::BlockNode *node) {
+    for (auto &exprNode : node->getExpr())
+        exprNode->accept(this);
+}
+
+void XrefBuilder::visit(AST::IfThenElseExprNode *node) {
+    node->getCondExpr()->accept(this);
+    node->getThenExpr()->accept(this);
+    if (node->getElseExpr() != NULL)
+        node->getElseExpr()->accept(this);
+}
+
+void XrefBuilder::visit(AST::WhileDoExprNode *node) {
+    node->getCondExpr()->accept(this);
+    node->getBodyExpr()->accept(this);
+}
+
+// The variable is only in scope in the scope expression
+void XrefBuilder::visit(AST::LetExprNode *node) {
+    useType(node->getTypeNode());
+    if (node->getInitExpr() != NULL)
+        node->getInitExpr()->accept(this);
+
+    locals.push_back(node->getName());
+    node->getScopeExpr()->accept(this);
+    locals.pop_back();
+}
+
+void XrefBuilder::visit(AST::AssignExprNode *node) {
+    useField(node->getNameStr(), node->getLine(), node->getColumn());
+    node->getExpr()->accept(this);
+}
+
+void XrefBuilder::visit(AST::NewExprNode *node) {
+    use(Xref::CLASS, node->getTypeName(), "", node->getLine(), node->getColumn());
+}
+
+void XrefBuilder::visit(AST::VariableExprNode *node) {
+    useField(node->getVariableName(), node->getLine(), node->getColumn());
+}
+
+void XrefBuilder::visit(AST::ArgsNode *node) {
+    for (auto &exprNode : node->getExprs())
+        exprNode->accept(this);
+}
+
+void XrefBuilder::visit(AST::CallExprNode *node) {
+    AST::ExprNode *objExprNode = node->getObjExpr();
+    objExprNode->accept(this);
+    if (node->getExprList() != NULL)
+        node->getExprList()->accept(this);
+
+    string definer = definingClass(objExprNode->getTypename(), node->getMethodName(), classMethodTypes);
+    if (!definer.empty())
+        use(Xref::METHOD, definer, node->getMethodName(), node->getLine(), node->getColumn());
+}
+
+bool XrefBuilder::write(const string &index_file, const string &source_file) const {
+    // Symbols sorted by names, then kinds
+    vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        const Entry &x = entries[a], &y = entries[b];
+        int c = x.className.compare(y.className);
+        if (c == 0)
+            c = x.name.compare(y.name);
+        return c != 0 ? c < 0 : x.kind < y.kind;
+    });
+
+    vector<uint32_t> position(entries.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        position[order[i]] = i;
+
+    // References grouped by symbol, in source order
+    vector<Use> sorted(uses);
+    for (Use &u : sorted) {
+        u.symbol = position[u.symbol];
+        u.from = position[u.from];
+    }
+    sort(sorted.begin(), sorted.end(), [](const Use &a, const Use &b) {
+        if (a.symbol != b.symbol)
+            return a.symbol < b.symbol;
+        return a.line != b.line ? a.line < b.line : a.column < b.column;
+    });
+
+    string strings;
+    unordered_map<string, uint32_t> offsets;
+    auto intern = [&](const string &s) {
+        auto it = offsets.emplace(s, strings.size());
+        if (it.second)
+            strings.append(s.c_str(), s.size() + 1);
+        return it.first->second;
+    };
+
+    Xref::Header header;
+    memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.file = intern(source_file);
+    header.symbols = entries.size();
+    header.references = sorted.size();
+
+    vector<Xref::Symbol> symbols(entries.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        const Entry &entry = entries[order[i]];
+        symbols[i] = {entry.kind, intern(entry.className), intern(entry.name), entry.line, entry.column, 0, 0};
+    }
+
+    vector<Xref::Reference> refs(sorted.size());
+    for (uint32_t i = 0; i < sorted.size(); i++) {
+        Xref::Symbol &symbol = symbols[sorted[i].symbol];
+        if (symbol.referenceCount++ == 0)
+            symbol.firstReference = i;
+
+        refs[i] = {sorted[i].line, sorted[i].column, sorted[i].from};
+    }
+
+    header.strings = strings.size();
+
+    ofstream out(index_file, ios::binary | ios::trunc);
+    out.write((const char *) &header, sizeof(header));
+    out.write((const char *) symbols.data(), symbols.size() * sizeof(Xref::Symbol));
+    out.write((const char *) refs.data(), refs.size() * sizeof(Xref::Reference));
+    out.write(strings.data(), strings.size());
+    out.close();
+
+    return !out.fail();
+}
+
+bool Xref::write(const string &index_file, AST::ProgramNode *program,
+                 const unordered_map<string, FirstPass::ClassInfo> &classInfoMap,
+                 const unordered_map<string, unordered_map<string, string>> &classMethodTypes,
+                 const unordered_map<string, unordered_map<string, string>> &classFieldTypes) {
+    XrefBuilder builder(classInfoMap, classMethodTypes, classFieldTypes);
+    program->accept(&builder);
+
+    if (!builder.write(index_file, program->getFilename())) {
+        cerr << "cannot write " << index_file << ": " << strerror(errno) << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+Xref::~Xref() {
+    if (data)
+        munmap(data, size);
+}
+
+bool Xref::open(const string &index_file) {
+    int fd = ::open(index_file.c_str(), O_RDONLY);
+    struct stat status;
+
+    if (fd < 0 || fstat(fd, &status) != 0) {
+        cerr << "cannot open " << index_file << ": " << strerror(errno) << '\n';
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    size = status.st_size;
+    if (size >= sizeof(Header))
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        cerr << "cannot map " << index_file << ": " << strerror(errno) << '\n';
+        return false;
+    }
+
+    // The sizes must add up, and the string table end with a NUL, so that
+    // any offset in it gives a string
+    header = (const Header *) data;
+    if (!data || memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version
+        || sizeof(Header) + (uint64_t) header->symbols * sizeof(Symbol)
+           + (uint64_t) header->references * sizeof(Reference) + header->strings != size
+        || header->strings == 0 || ((const char *) data)[size - 1] != '\0') {
+        cerr << index_file << " is not a cross-reference index, run vsopc --xref -c again\n";
+        return false;
+    }
+
+    symbols = (const Symbol *) (header + 1);
+    refs = (const Reference *) (symbols + header->symbols);
+    strings = (const char *) (refs + header->references);
+
+    return true;
+}
+
+const char *Xref::string_at(uint32_t offset) const {
+    return offset < header->strings ? strings + offset : "";
+}
+
+pair<const Xref::Symbol *, const Xref::Symbol *> Xref::find(const string &className, const string &member) const {
+    auto compare = [this](const Symbol &symbol, const pair<const char *, const char *> &name) {
+        int c = strcmp(string_at(symbol.className), name.first);
+        return c != 0 ? c < 0 : strcmp(string_at(symbol.name), name.second) < 0;
+    };
+
+    pair<const char *, const char *> name(className.c_str(), member.c_str());
+    const Symbol *end = symbols + header->symbols;
+    const Symbol *first = lower_bound(symbols, end, name, compare);
+
+    const Symbol *last = first;
+    while (last != end && className == string_at(last->className) && member == string_at(last->name))
+        last++;
+
+    return make_pair(first, last);
+}
+
+void Xref::print_name(const Symbol &symbol, ostream &out) const {
+    out << string_at(symbol.className);
+    if (symbol.kind != CLASS)
+        out << '.' << string_at(symbol.name);
+}
+
+void Xref::print_position(uint32_t line, uint32_t column, ostream &out) const {
+    if (line == 0)
+        out << "built-in";
+    else
+        out << string_at(header->file) << ':' << line << ':' << column;
+}
+
+size_t Xref::definitions(const string &className, const string &member, ostream &out) const {
+    auto range = find(className, member);
+
+    for (const Symbol *symbol = range.first; symbol != range.second; symbol++) {
+        print_position(symbol->line, symbol->column, out);
+        out << ": " << (symbol->kind <= METHOD ? kind_names[symbol->kind] : "symbol") << ' ';
+        print_name(*symbol, out);
+        out << '\n';
+    }
+
+    return range.second - range.first;
+}
+
+size_t Xref::references(const string &className, const string &member, ostream &out) const {
+    auto range = find(className, member);
+
+    for (const Symbol *symbol = range.first; symbol != range.second; symbol++) {
+        if ((uint64_t) symbol->firstReference + symbol->referenceCount > header->references)
+            continue;
+
+        const Reference *end = refs + symbol->firstReference + symbol->referenceCount;
+        for (const Reference *ref = refs + symbol->firstReference; ref != end; ref++) {
+            print_position(ref->line, ref->column, out);
+            out << ": in ";
+            if (ref->symbol < header->symbols)
+                print_name(symbols[ref->symbol], out);
+            out << '\n';
+        }
+    }
+
+    return range.second - range.first;
+}
@@ -0,0 +1,166 @@
+#ifndef _XREF_HPP
+#define _XREF_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "ast.hpp"
+#include "firstPass.hpp"
+
+namespace VSOP {
+    /**
+     * @brief Symbol and cross-reference index of a checked program, in a
+     * binary file which the queries map in memory.
+     *
+     * The symbols are the classes, fields and methods, sorted by class and
+     * member names so that a query is a binary search. The references to a
+     * symbol are contiguous, in source order:
+     *   - a class is referenced by the types, the new expressions and the
+     *     extends clauses naming it,
+     *   - a field by the identifiers and assignments bound to it,
+     *   - a method by the calls resolved to it on the static type of their
+     *     object.
+     *
+     * A reference is at the position of the node containing it: a call is
+     * at the start of its object expression, or at the method name if the
+     * object is an implicit self, and an extends clause is at the class
+     * keyword of the class declaring it.
+     *
+     * File layout, in native byte order:
+     *   Header     magic "VXRF", version, file name, symbol, reference and
+     *              string table sizes
+     *   Symbol[]   kind, class name, member name, line, column, first
+     *              reference, reference count
+     *   Reference[] line, column, symbol containing the reference
+     *   strings    NUL-terminated, the names are offsets in this table
+     */
+    class Xref {
+        public:
+            /**
+             * @brief Kinds of symbols, a class symbol has an empty member name.
+             */
+            enum Kind : std::uint32_t {
+                CLASS,
+                FIELD,
+                METHOD
+            };
+
+            /**
+             * @brief Write the index of a program checked by FourthPass.
+             *
+             * @param index_file The name of the index file.
+             * @param program The checked program.
+             * @param classInfoMap The classes, from FirstPass.
+             * @param classMethodTypes The methods of each class, from SecondPass.
+             * @param classFieldTypes The fields of each class, from SecondPass.
+             *
+             * @return bool false if the file cannot be written.
+             */
+            static bool write(const std::string &index_file, AST::ProgramNode *program,
+                              const std::unordered_map<std::string, FirstPass::ClassInfo> &classInfoMap,
+                              const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> &classMethodTypes,
+                              const std::unordered_map<std::string, std::unordered_map<std::string, std::string>> &classFieldTypes);
+
+            Xref() = default;
+            ~Xref();
+
+            Xref(const Xref &) = delete;
+            Xref &operator=(const Xref &) = delete;
+
+            /**
+             * @brief Map an index file in memory.
+             *
+             * @param index_file The name of the index file.
+             *
+             * @return bool false if the file cannot be mapped or is not an
+             * index, the reason is printed on stderr.
+             */
+            bool open(const std::string &index_file);
+
+            /**
+             * @brief Print the definitions of the symbols of a class and
+             * member name, as file:line:column: kind Class.member.
+             *
+             * @param className The name of the class.
+             * @param member The name of the field or method, empty for the class.
+             * @param out The stream receiving the definitions.
+             *
+             * @return std::size_t The number of symbols found.
+             */
+            std::size_t definitions(const std::string &className, const std::string &member, std::ostream &out) const;
+
+            /**
+             * @brief Print the references to the symbols of a class and
+             * member name, as file:line:column: in Class.member.
+             *
+             * @param className The name of the class.
+             * @param member The name of the field or method, empty for the class.
+             * @param out The stream receiving the references.
+             *
+             * @return std::size_t The number of symbols found.
+             */
+            std::size_t references(const std::string &className, const std::string &member, std::ostream &out) const;
+
+        private:
+            struct Header {
+                char magic[4];
+                std::uint32_t version;
+                std::uint32_t file;
+                std::uint32_t symbols;
+                std::uint32_t references;
+                std::uint32_t strings;
+            };
+
+            struct Symbol {
+                std::uint32_t kind;
+                std::uint32_t className;
+                std::uint32_t name;
+                std::uint32_t line;
+                std::uint32_t column;
+                std::uint32_t firstReference;
+                std::uint32_t referenceCount;
+            };
+
+            struct Reference {
+                std::uint32_t line;
+                std::uint32_t column;
+                std::uint32_t symbol;
+            };
+
+            friend class XrefBuilder;
+
+            void *data = nullptr;
+            std::size_t size = 0;
+
+            const Header *header = nullptr;
+            const Symbol *symbols = nullptr;
+            const Reference *refs = nullptr;
+            const char *strings = nullptr;
+
+            /**
+             * @brief A string of the table, empty if the offset is outside.
+             */
+            const char *string_at(std::uint32_t offset) const;
+
+            /**
+             * @brief The range of the symbols of a class and member name.
+             */
+            std::pair<const Symbol *, const Symbol *> find(const std::string &className, const std::string &member) const;
+
+            /**
+             * @brief Print a symbol as Class.member, or Class.
+             */
+            void print_name(const Symbol &symbol, std::ostream &out) const;
+
+            /**
+             * @brief Print a position in the file, or built-in for Object.
+             */
+            void print_position(std::uint32_t line, std::uint32_t column, std::ostream &out) const;
+    };
+}
+
+#endif